@@ -1,6 +1,19 @@
 #include "pch.h"
 #include <fstream>
+#include <map>
+#include <random>
 #include "../magneto_lib/Job.h"
+#include "../magneto_lib/PaddedLattice.h"
+#include "../magneto_lib/LatticeAlgorithms.h"
+#include "../magneto_lib/MultiSpinMetropolis.h"
+#include "../magneto_lib/CheckerboardMetropolis.h"
+#include "../magneto_lib/SimdMetropolis.h"
+#include "../magneto_lib/ParallelSW.h"
+#include "../magneto_lib/CounterRng.h"
+#include "../magneto_lib/Reweighting.h"
+#include "../magneto_lib/Statistics.h"
+#include "../magneto_lib/TaskScheduler.h"
+#include "../magneto_lib/ThreadPlan.h"
 
 namespace {
    std::string get_file_contents(const std::filesystem::path& path) {
@@ -15,6 +28,140 @@ namespace {
       filestream.close();
       return buffer.str();
    }
+
+
+   magneto::SpinLattice get_random_lattice(const int Lx, const int Ly, const unsigned int seed) {
+      std::mt19937 rng(seed);
+      magneto::SpinLattice lattice(Lx, Ly);
+      for (int i = 0; i < Ly; ++i) {
+         for (int j = 0; j < Lx; ++j)
+            lattice.set(i, j, rng() >> 31 ? 1 : -1);
+      }
+      return lattice;
+   }
+
+
+   bool are_equal(const magneto::SpinLattice& a, const magneto::SpinLattice& b) {
+      for (int i = 0; i < a.get_Ly(); ++i) {
+         for (int j = 0; j < a.get_Lx(); ++j) {
+            if (a(i, j) != b(i, j))
+               return false;
+         }
+      }
+      return true;
+   }
+
+
+   /// <summary>Runs both algorithms side by side from the same lattice and expects the same lattice
+   /// after every sweep. At T->0 no uphill move is accepted and every other one is, so this holds
+   /// whatever random numbers the two use.</summary>
+   void expect_same_sweeps(
+      magneto::LatticeAlgorithm& algorithm,
+      magneto::LatticeAlgorithm& reference,
+      const magneto::SpinLattice& start,
+      const int sweeps
+   ) {
+      magneto::SpinLattice lattice = start;
+      magneto::SpinLattice expected = start;
+      for (int sweep = 0; sweep < sweeps; ++sweep) {
+         algorithm.run(lattice);
+         algorithm.write_back(lattice);
+         reference.run(expected);
+         EXPECT_TRUE(are_equal(lattice, expected)) << "after sweep " << sweep;
+      }
+   }
+
+
+   /// <summary>Reference cluster labels at T=0, where every aligned bond freezes: a flood fill of the
+   /// aligned neighbours with periodic boundaries</summary>
+   std::vector<int> get_reference_clusters(const magneto::SpinLattice& lattice) {
+      const int Lx = lattice.get_Lx();
+      const int Ly = lattice.get_Ly();
+      std::vector<int> labels(Lx * Ly, -1);
+      for (int start = 0; start < Lx * Ly; ++start) {
+         if (labels[start] != -1)
+            continue;
+         std::vector<int> stack = { start };
+         labels[start] = start;
+         while (!stack.empty()) {
+            const int site = stack.back();
+            stack.pop_back();
+            const int i = site / Lx;
+            const int j = site % Lx;
+            const int neighbours[4] = {
+               i * Lx + (j + 1) % Lx, i * Lx + (j + Lx - 1) % Lx, (i + 1) % Ly * Lx + j, (i + Ly - 1) % Ly * Lx + j
+            };
+            for (const int neighbour : neighbours) {
+               if (labels[neighbour] == -1 && lattice(neighbour / Lx, neighbour % Lx) == lattice(i, j)) {
+                  labels[neighbour] = start;
+                  stack.push_back(neighbour);
+               }
+            }
+         }
+      }
+      return labels;
+   }
+
+
+   /// <summary>Runs a cluster algorithm at T->0 on random lattices. Every cluster has to flip as a whole,
+   /// and with this many clusters some flip and some don't.</summary>
+   void expect_whole_clusters_flip(magneto::LatticeAlgorithm& algorithm, const int Lx, const int Ly) {
+      for (unsigned int seed = 0; seed < 5; ++seed) {
+         const magneto::SpinLattice before = get_random_lattice(Lx, Ly, seed);
+         const std::vector<int> clusters = get_reference_clusters(before);
+         magneto::SpinLattice lattice = before;
+         algorithm.run(lattice);
+
+         std::vector<int> flips(Lx * Ly, -1);
+         for (int site = 0; site < Lx * Ly; ++site) {
+            const int flipped = lattice(site / Lx, site % Lx) != before(site / Lx, site % Lx);
+            if (flips[clusters[site]] == -1)
+               flips[clusters[site]] = flipped;
+            EXPECT_EQ(flips[clusters[site]], flipped);
+         }
+         EXPECT_NE(std::count(flips.cbegin(), flips.cend(), 0), 0);
+         EXPECT_NE(std::count(flips.cbegin(), flips.cend(), 1), 0);
+      }
+   }
+
+
+   /// <summary>Number of states of a 4x4 lattice per total energy and absolute magnetization, by
+   /// enumeration</summary>
+   std::map<std::pair<int, int>, int> get_exact_4x4_states() {
+      std::map<std::pair<int, int>, int> states;
+      for (unsigned int state = 0; state < (1u << 16); ++state) {
+         const auto get_spin = [&](const int i, const int j) {return (state >> ((i % 4) * 4 + j % 4)) & 1u ? 1 : -1; };
+         int energy = 0;
+         int magnetization = 0;
+         for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j) {
+               energy -= get_spin(i, j) * (get_spin(i, j + 1) + get_spin(i + 1, j));
+               magnetization += get_spin(i, j);
+            }
+         }
+         ++states[{ energy, std::abs(magnetization) }];
+      }
+      return states;
+   }
+
+
+   /// <summary>Exact canonical results of the 4x4 lattice, normalized like get_physical_results</summary>
+   magneto::PhysicsResult get_exact_4x4_result(const std::map<std::pair<int, int>, int>& states, const double T) {
+      double z = 0.0, e = 0.0, e2 = 0.0, m = 0.0, m2 = 0.0;
+      for (const auto& [key, count] : states) {
+         const double weight = count * exp(-key.first / T);
+         const double site_energy = key.first / 16.0;
+         const double site_magnetization = key.second / 16.0;
+         z += weight;
+         e += weight * site_energy;
+         e2 += weight * site_energy * site_energy;
+         m += weight * site_magnetization;
+         m2 += weight * site_magnetization * site_magnetization;
+      }
+      e /= z;
+      m /= z;
+      return { T, e, (e2 / z - e * e) * 16 / (T * T), m, (m2 / z - m * m) * 16 / T };
+   }
 }
 
 
@@ -33,14 +180,414 @@ public:
    //magneto::Job job1;
    //magneto::Job job2;
    //magneto::Job job3;
-   magneto::Job empty_job;
+   magneto::JsonJob empty_job;
 };
 
 
 TEST_F(Jobs, EqualityOperators) {
    EXPECT_TRUE(magneto::PhysicsConfig({ "file", "{E}" }) == magneto::PhysicsConfig({ "file", "{E}" }));
-   magneto::Job job1;
-   magneto::Job job2;
+   magneto::JsonJob job1;
+   magneto::JsonJob job2;
    EXPECT_TRUE(job1==job2);
 }
 
+
+// log f and the target error are far below the tolerance of the temperatures
+TEST_F(Jobs, ComparesSmallValuesRelatively) {
+   magneto::JsonJob job1;
+   magneto::JsonJob job2;
+   job2.wang_landau_log_f = job1.wang_landau_log_f / 2;
+   EXPECT_FALSE(job1 == job2);
+   job2.wang_landau_log_f = job1.wang_landau_log_f;
+   job2.target_rel_error = 0.0005;
+   EXPECT_FALSE(job1 == job2);
+   job1.target_rel_error = 0.0005;
+   EXPECT_TRUE(job1 == job2);
+}
+
+
+TEST_F(Jobs, GivesNoJobForInvalidSchedules) {
+   magneto::JsonJob json_job;
+   EXPECT_TRUE(magneto::get_job(json_job).has_value());
+   json_job.schedule_config.m_mode = magneto::Schedule::Linear;
+   json_job.schedule_config.m_t_start = -1.0;
+   json_job.schedule_config.m_t_end = 1.0;
+   EXPECT_FALSE(magneto::get_job(json_job).has_value());
+}
+
+
+TEST(PaddedLattice, HaloFollowsSet) {
+   const int Lx = 5;
+   const int Ly = 4;
+   magneto::PaddedLattice<int> lattice(Lx, Ly);
+   for (int i = 0; i < Ly; ++i) {
+      for (int j = 0; j < Lx; ++j)
+         lattice.set(i, j, i * Lx + j + 1);
+   }
+   const int stride = lattice.get_stride();
+   for (int i = 0; i < Ly; ++i) {
+      for (int j = 0; j < Lx; ++j) {
+         const int k = lattice.get_index(i, j);
+         EXPECT_EQ(lattice[k - 1], lattice(i, (j + Lx - 1) % Lx));
+         EXPECT_EQ(lattice[k + 1], lattice(i, (j + 1) % Lx));
+         EXPECT_EQ(lattice[k - stride], lattice((i + Ly - 1) % Ly, j));
+         EXPECT_EQ(lattice[k + stride], lattice((i + 1) % Ly, j));
+      }
+   }
+}
+
+
+// Widths of 70 and 130 leave a partial word at the end of every row
+TEST(MultiSpinMetropolis, MatchesCheckerboardAtZeroTemperature) {
+   for (const int J : { 1, -1 }) {
+      for (const auto [Lx, Ly] : { std::pair(64, 8), std::pair(70, 12), std::pair(130, 6) }) {
+         const magneto::CounterRng rng(3, 0);
+         magneto::MultiSpinMetropolis multi_spin(J, 0.01, Lx, Ly, rng);
+         magneto::CheckerboardMetropolis checkerboard(J, 0.01, Lx, Ly, rng, 1);
+         expect_same_sweeps(multi_spin, checkerboard, get_random_lattice(Lx, Ly, Lx), 5);
+      }
+   }
+}
+
+
+// The packed lattice stays resident between run() calls and only write_back() unpacks it
+TEST(MultiSpinMetropolis, WriteBackAfterSeveralSweeps) {
+   const int Lx = 70;
+   const int Ly = 12;
+   const magneto::CounterRng rng(5, 0);
+   magneto::MultiSpinMetropolis multi_spin(1, 0.01, Lx, Ly, rng);
+   magneto::CheckerboardMetropolis checkerboard(1, 0.01, Lx, Ly, rng, 1);
+   const magneto::SpinLattice start = get_random_lattice(Lx, Ly, 5);
+   magneto::SpinLattice lattice = start;
+   magneto::SpinLattice expected = start;
+   for (int sweep = 0; sweep < 4; ++sweep) {
+      multi_spin.run(lattice);
+      checkerboard.run(expected);
+   }
+   EXPECT_TRUE(are_equal(lattice, start));
+   EXPECT_FALSE(are_equal(expected, start));
+
+   multi_spin.write_back(lattice);
+   EXPECT_TRUE(are_equal(lattice, expected));
+   multi_spin.write_back(lattice);
+   EXPECT_TRUE(are_equal(lattice, expected));
+
+   // The halo has to be written back as well, the next sweep reads it
+   multi_spin.run(lattice);
+   multi_spin.write_back(lattice);
+   checkerboard.run(expected);
+   EXPECT_TRUE(are_equal(lattice, expected));
+}
+
+
+// A lattice overwritten in place keeps its address, so run() only packs it again after reset_totals()
+TEST(MultiSpinMetropolis, OverwriteInPlaceNeedsResetTotals) {
+   const int Lx = 70;
+   const int Ly = 12;
+   const magneto::CounterRng rng(5, 0);
+   magneto::MultiSpinMetropolis multi_spin(1, 0.01, Lx, Ly, rng);
+   magneto::CheckerboardMetropolis checkerboard(1, 0.01, Lx, Ly, rng, 1);
+   const auto overwrite = [&](magneto::SpinLattice& lattice, const magneto::SpinLattice& source) {
+      for (int i = 0; i < Ly; ++i) {
+         for (int j = 0; j < Lx; ++j)
+            lattice.set(i, j, source(i, j));
+      }
+   };
+   magneto::SpinLattice lattice = get_random_lattice(Lx, Ly, 1);
+   magneto::SpinLattice expected = lattice;
+   multi_spin.run(lattice);
+   checkerboard.run(expected);
+
+   // Without reset_totals() the sweeps continue on the packed copy
+   const magneto::SpinLattice replacement = get_random_lattice(Lx, Ly, 2);
+   overwrite(lattice, replacement);
+   multi_spin.run(lattice);
+   multi_spin.write_back(lattice);
+   checkerboard.run(expected);
+   EXPECT_TRUE(are_equal(lattice, expected));
+
+   overwrite(lattice, replacement);
+   expected = replacement;
+   multi_spin.reset_totals();
+   for (int sweep = 0; sweep < 3; ++sweep) {
+      multi_spin.run(lattice);
+      multi_spin.write_back(lattice);
+      checkerboard.run(expected);
+      EXPECT_TRUE(are_equal(lattice, expected)) << "after sweep " << sweep;
+   }
+}
+
+
+// Every kernel this CPU supports, with widths that leave a scalar remainder
+TEST(SimdMetropolis, MatchesCheckerboardAtZeroTemperature) {
+   for (const magneto::SimdLevel level : { magneto::SimdLevel::SSE2, magneto::SimdLevel::AVX2, magneto::SimdLevel::AVX512 }) {
+      if (level > magneto::get_simd_level())
+         continue;
+      for (const int J : { 1, -1 }) {
+         for (const auto [Lx, Ly] : { std::pair(64, 8), std::pair(70, 12), std::pair(18, 6) }) {
+            SCOPED_TRACE("level " + std::to_string(static_cast<int>(level)));
+            const magneto::CounterRng rng(9, 0);
+            magneto::SimdMetropolis simd(J, 0.01, Lx, Ly, rng, level);
+            magneto::CheckerboardMetropolis checkerboard(J, 0.01, Lx, Ly, rng, 1);
+            expect_same_sweeps(simd, checkerboard, get_random_lattice(Lx, Ly, Lx), 5);
+         }
+      }
+   }
+}
+
+
+TEST(TemperatureTable, AcceptanceOfEveryColumn) {
+   const magneto::LatticeDType T(2, std::vector<double>(3, 1.5));
+   for (const int J : { 1, -1, 2 }) {
+      const magneto::TemperatureTable table(J, T);
+      for (const int dE : { -8, -4, 0, 4, 8 })
+         EXPECT_DOUBLE_EQ(table.get_probability(1, 2, dE * std::abs(J)), std::min(1.0, exp(-dE * std::abs(J) / 1.5)));
+   }
+
+   // Without coupling every energy change is 0
+   const magneto::TemperatureTable table(0, T);
+   EXPECT_DOUBLE_EQ(table.get_probability(1, 2, 0), 1.0);
+   EXPECT_EQ(table.get_threshold(1, 2, 0), std::numeric_limits<uint32_t>::max());
+}
+
+
+TEST(SW, FlipsWholeReferenceClusters) {
+   magneto::SW sw(1, 0.01, 16, 12, magneto::CounterRng(7, 0), magneto::Acceptance::Double, magneto::RandomMode::OnDemand);
+   expect_whole_clusters_flip(sw, 16, 12);
+}
+
+
+// Strips of unequal height with 5 threads
+TEST(ParallelSW, FlipsWholeReferenceClusters) {
+   for (const int threads : { 2, 4, 5 }) {
+      magneto::ParallelSW sw(1, 0.01, 16, 12, magneto::CounterRng(7, 0), threads);
+      expect_whole_clusters_flip(sw, 16, 12);
+   }
+}
+
+
+// Known-answer vectors of Philox4x32-10 from the Random123 distribution
+TEST(CounterRng, PhiloxKnownAnswers) {
+   using Block = std::array<uint32_t, 4>;
+   EXPECT_EQ(magneto::get_philox4x32({ 0, 0, 0, 0 }, { 0, 0 }), Block({ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }));
+   EXPECT_EQ(
+      magneto::get_philox4x32({ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }),
+      Block({ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd })
+   );
+   EXPECT_EQ(
+      magneto::get_philox4x32({ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }),
+      Block({ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 })
+   );
+}
+
+
+TEST(CounterRng, StreamsAreReproducibleAndDistinct) {
+   const magneto::CounterRng rng(42, 1);
+   EXPECT_EQ(rng.get_words(3, 5), magneto::CounterRng(42, 1).get_words(3, 5));
+   EXPECT_NE(rng.get_words(3, 5), magneto::CounterRng(42, 2).get_words(3, 5));
+   EXPECT_NE(rng.get_words(3, 5), magneto::CounterRng(42, 1, magneto::RngPhase::Warmup).get_words(3, 5));
+   EXPECT_NE(rng.get_words(3, 5), rng.get_words(3, 5, 1));
+   EXPECT_NE(rng.get_words(3, 5), rng.get_words(4, 5));
+}
+
+
+// The samples of every temperature are the exact Boltzmann distribution of a 4x4 lattice, rounded to
+// whole measurements. Reweighting them has to give the exact results in between.
+TEST(Reweighting, MultiHistogramRoundTrip) {
+   const std::map<std::pair<int, int>, int> states = get_exact_4x4_states();
+   const int samples_per_temperature = 50000;
+   std::vector<magneto::PhysicalProperties> properties;
+   for (const double T : { 2.0, 2.5, 3.0 }) {
+      magneto::PhysicalProperties run;
+      run.T = T;
+      run.Lx = 4;
+      run.Ly = 4;
+      double z = 0.0;
+      for (const auto& [key, count] : states)
+         z += count * exp(-key.first / T);
+      for (const auto& [key, count] : states) {
+         const int repetitions = static_cast<int>(std::lround(samples_per_temperature * count * exp(-key.first / T) / z));
+         run.measurements.insert(run.measurements.end(), repetitions, { key.first / 16.0, key.second / 16.0 });
+      }
+      properties.emplace_back(run);
+   }
+
+   const std::vector<double> temps = { 2.0, 2.25, 2.75, 3.0 };
+   const std::vector<magneto::PhysicsResult> results = magneto::get_multi_histogram_results(properties, 1, temps);
+   ASSERT_EQ(results.size(), temps.size());
+   for (size_t k = 0; k < temps.size(); ++k) {
+      const magneto::PhysicsResult exact = get_exact_4x4_result(states, temps[k]);
+      EXPECT_NEAR(results[k].energy, exact.energy, 1e-4);
+      EXPECT_NEAR(results[k].cv, exact.cv, 1e-4);
+      EXPECT_NEAR(results[k].magnetization, exact.magnetization, 1e-4);
+      EXPECT_NEAR(results[k].chi, exact.chi, 1e-4);
+   }
+}
+
+
+TEST(Statistics, MergeEqualsConcatenation) {
+   std::mt19937_64 generator(5);
+   std::normal_distribution<double> distribution(-1.5, 0.2);
+   magneto::MeasurementStatistics whole, first, second;
+   for (int k = 0; k < 3001; ++k) {
+      const double energy = distribution(generator);
+      const double magnetization = std::abs(distribution(generator) + 1.0);
+      whole.add(energy, magnetization);
+      (k < 1000 ? first : second).add(energy, magnetization);
+   }
+   first.merge(second);
+   EXPECT_EQ(first.m_energy.get_count(), whole.m_energy.get_count());
+   EXPECT_NEAR(first.m_energy.get_mean(), whole.m_energy.get_mean(), 1e-12);
+   EXPECT_NEAR(first.m_energy.get_variance(), whole.m_energy.get_variance(), 1e-12);
+   EXPECT_NEAR(first.m_magnetization.get_mean(), whole.m_magnetization.get_mean(), 1e-12);
+   EXPECT_NEAR(first.m_magnetization.get_variance(), whole.m_magnetization.get_variance(), 1e-12);
+   EXPECT_NEAR(first.get_binder_cumulant(), whole.get_binder_cumulant(), 1e-12);
+}
+
+
+TEST(Statistics, KahanSumKeepsSmallTerms) {
+   magneto::KahanSum sum;
+   sum.add(1.0);
+   for (int k = 0; k < 1000000; ++k)
+      sum.add(1e-16);
+   EXPECT_NEAR(sum.get(), 1.0 + 1e-10, 1e-15);
+}
+
+
+// An AR(1) series x_t = phi x_(t-1) + noise has the squared error of the mean
+// sigma^2 (1+phi) / ((1-phi) n), with sigma^2 = 1/(1-phi^2) for unit noise
+TEST(Statistics, BlockingErrorOfCorrelatedSeries) {
+   const double phi = 0.8;
+   const int n = 1 << 17;
+   std::mt19937_64 generator(11);
+   std::normal_distribution<double> noise;
+   magneto::BlockingAnalysis blocking;
+   magneto::RunningMoments moments;
+   double x = 0.0;
+   for (int t = 0; t < n; ++t) {
+      x = phi * x + noise(generator);
+      blocking.add(x);
+      moments.add(x);
+   }
+   const double exact_error = std::sqrt((1.0 + phi) / ((1.0 - phi) * (1.0 - phi * phi) * n));
+   const double naive_error = std::sqrt(moments.get_variance() / n);
+   EXPECT_LT(naive_error, 0.5 * exact_error);
+   EXPECT_GT(blocking.get_error(), 0.7 * exact_error);
+   EXPECT_LT(blocking.get_error(), 1.4 * exact_error);
+}
+
+
+TEST(Statistics, MserCutsTheTransient) {
+   std::mt19937_64 generator(3);
+   std::normal_distribution<double> noise(0.0, 0.1);
+   std::vector<double> relaxing, stationary, drifting;
+   for (int t = 0; t < 2000; ++t) {
+      relaxing.emplace_back(2.0 * std::exp(-t / 50.0) + noise(generator));
+      stationary.emplace_back(noise(generator));
+      drifting.emplace_back(0.001 * t + noise(generator));
+   }
+   // The transient is below the noise after about 150 values
+   EXPECT_GT(magneto::get_mser_truncation(relaxing), 100u);
+   EXPECT_LT(magneto::get_mser_truncation(relaxing), 400u);
+   EXPECT_LT(magneto::get_mser_truncation(stationary), 100u);
+   EXPECT_GT(magneto::get_mser_truncation(drifting), drifting.size() / 2);
+}
+
+
+TEST(TaskScheduler, RunsEveryTaskOnce) {
+   std::atomic<unsigned int> started_workers = 0;
+   {
+      magneto::TaskScheduler scheduler(4, [&](const unsigned int /*worker*/) {++started_workers; });
+      EXPECT_EQ(scheduler.get_worker_count(), 4u);
+      for (int repetition = 0; repetition < 3; ++repetition) {
+         std::vector<std::atomic<int>> runs(200);
+         std::vector<magneto::Task> tasks;
+         for (size_t k = 0; k < runs.size(); ++k)
+            tasks.push_back({ static_cast<double>(k % 7), [&runs, k] {++runs[k]; } });
+         scheduler.run(std::move(tasks));
+         for (const std::atomic<int>& count : runs)
+            EXPECT_EQ(count, 1);
+      }
+   }
+   // Workers can still be starting while others do all the work, so this is only certain once they're joined
+   EXPECT_EQ(started_workers, 4u);
+}
+
+
+TEST(ThreadPlan, SplitsTheBudget) {
+   magneto::Job job;
+   job.m_threads = 8;
+   job.m_pin_threads = false;
+
+   // Temperatures get the threads first
+   job.m_algorithm = magneto::Algorithm::Metropolis;
+   magneto::ThreadPlan plan = magneto::get_thread_plan(job, 3);
+   EXPECT_EQ(plan.m_budget, 8u);
+   EXPECT_EQ(plan.m_temperature_threads, 3u);
+   EXPECT_EQ(plan.m_lattice_threads, 1u);
+   EXPECT_EQ(plan.m_rng_threads, 0u);
+
+   // The rest goes to the lattices of the parallel algorithms, if they are large enough
+   job.m_algorithm = magneto::Algorithm::ParallelSW;
+   job.m_Lx = 512;
+   job.m_Ly = 512;
+   plan = magneto::get_thread_plan(job, 2);
+   EXPECT_EQ(plan.m_temperature_threads, 2u);
+   EXPECT_EQ(plan.m_lattice_threads, 4u);
+   job.m_Lx = 64;
+   job.m_Ly = 64;
+   plan = magneto::get_thread_plan(job, 2);
+   EXPECT_EQ(plan.m_lattice_threads, 1u);
+
+   // An explicit algorithm_threads is kept and the temperatures share what remains
+   job.m_algorithm_threads = 3;
+   plan = magneto::get_thread_plan(job, 10);
+   EXPECT_EQ(plan.m_lattice_threads, 3u);
+   EXPECT_EQ(plan.m_temperature_threads, 2u);
+   job.m_algorithm_threads = 0;
+
+   // The buffered SW takes its RNG threads from the budget, but always gets one
+   job.m_algorithm = magneto::Algorithm::SW;
+   job.m_random_mode = magneto::RandomMode::Buffered;
+   plan = magneto::get_thread_plan(job, 20);
+   EXPECT_EQ(plan.m_rng_threads, 1u);
+   EXPECT_EQ(plan.m_temperature_threads, 7u);
+   job.m_threads = 1;
+   plan = magneto::get_thread_plan(job, 20);
+   EXPECT_EQ(plan.m_rng_threads, 1u);
+   EXPECT_EQ(plan.m_temperature_threads, 1u);
+}
+
+
+TEST_F(Jobs, ParsesTheSimulationKeys) {
+   EXPECT_TRUE(empty_job == magneto::JsonJob());
+
+   const magneto::JsonJob job = magneto::get_parsed_job(std::string(R"({
+      "algorithm": "SW_parallel", "acceptance": "double", "random_mode": "on_demand", "seed": 1234,
+      "threads": 6, "pin_threads": false, "algorithm_threads": 2, "exchange_interval": 10,
+      "wang_landau": true, "wang_landau_windows": 3, "wang_landau_log_f": 1e-5,
+      "keep_time_series": true, "continuation": true, "target_rel_error": 0.01, "max_iterations": 5000,
+      "equilibration": "auto", "thinning": "auto",
+      "reweighting": "multi", "reweight_t_min": 2.1, "reweight_t_max": 2.4, "reweight_t_steps": 7, "reweight_path": "rw.txt",
+      "schedule": "exponential", "schedule_t_start": 3.0, "schedule_t_end": 1.5, "schedule_steps": 4, "schedule_path": "s.txt"
+   })"));
+   EXPECT_EQ(job.algorithm, magneto::Algorithm::ParallelSW);
+   EXPECT_EQ(job.acceptance, magneto::Acceptance::Double);
+   EXPECT_EQ(job.random_mode, magneto::RandomMode::OnDemand);
+   EXPECT_EQ(job.seed, 1234u);
+   EXPECT_EQ(job.threads, 6u);
+   EXPECT_FALSE(job.pin_threads);
+   EXPECT_EQ(job.algorithm_threads, 2u);
+   EXPECT_EQ(job.exchange_interval, 10u);
+   EXPECT_TRUE(job.wang_landau);
+   EXPECT_EQ(job.wang_landau_windows, 3u);
+   EXPECT_DOUBLE_EQ(job.wang_landau_log_f, 1e-5);
+   EXPECT_TRUE(job.keep_time_series);
+   EXPECT_TRUE(job.continuation);
+   EXPECT_DOUBLE_EQ(job.target_rel_error, 0.01);
+   EXPECT_EQ(job.max_iterations, 5000u);
+   EXPECT_EQ(job.equilibration, magneto::Equilibration::Automatic);
+   EXPECT_EQ(job.thinning, magneto::Thinning::Automatic);
+   EXPECT_TRUE(job.reweight_config == magneto::ReweightConfig({ magneto::Reweighting::Multi, 2.1, 2.4, 7, "rw.txt" }));
+   EXPECT_TRUE(job.schedule_config == magneto::ScheduleConfig({ magneto::Schedule::Exponential, 3.0, 1.5, 4, {}, "s.txt" }));
+}
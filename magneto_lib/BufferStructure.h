@@ -1,30 +1,52 @@
 #pragma once
 
-#include <future>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
 
 
 namespace magneto {
 
-   /// <summary>Structure that bundles a data buffer, the futures that compute the next buffer
-   /// content concurrently, and the function to compute them all in one.</summary>
+   /// <summary>Ring of preallocated buffers that are refilled in the background by the RngPool
+   /// <para>One buffer is in use, the others are being filled or ready. The filler writes into the
+   /// existing buffer, so after the first round no memory is allocated anymore. It gets the
+   /// running number of the buffer, which makes the content reproducible with a counter-based
+   /// generator.</para>
+   /// </summary>
    template<class T>
    class BufferStructure {
    public:
-      BufferStructure(const std::function<T()>& generator_fun, const int max_rng_threads);
+      using Filler = std::function<void(T& buffer, const uint32_t buffer_number)>;
+
+      BufferStructure(const Filler& filler, const int ring_size);
       ~BufferStructure();
+      BufferStructure(const BufferStructure&) = delete;
+      BufferStructure& operator=(const BufferStructure&) = delete;
 
-      /// <summary>Returns reference to the buffer content</summary>
+      /// <summary>Returns reference to the buffer content. Only valid until the next refill().</summary>
       [[nodiscard]] const T& get_buffer() const;
 
-      /// <summary>Refills the internal buffer with result from finished computing threat and restarts that it.</summary>
+      /// <summary>Hands the current buffer back for refilling and switches to the next one in the
+      /// ring. Blocks if that one isn't ready yet, the time is counted in the RngPool.</summary>
       void refill();
 
    private:
-      void move_future_results_and_restart(std::future<T>& future);
-
-      T m_buffer;
-      std::vector<std::future<T>> m_futures;
-      std::function<T()> m_buffer_filler;
+      struct Slot {
+         T m_buffer;
+         bool m_ready = false;
+      };
+
+      void submit(const size_t slot);
+
+      std::vector<Slot> m_ring;
+      size_t m_current = 0;
+      uint32_t m_next_buffer_number = 0;
+      int m_pending = 0;
+      Filler m_filler;
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
    };
 }
 
@@ -1,75 +1,69 @@
 #pragma once
 
 #include "BufferStructure.h"
+#include "RngPool.h"
 
-namespace {
-
-   template<class T>
-   void finish_futures(T& first_futures) {
-      for (auto& future : first_futures)
-         future.get();
-   }
-
-   template <class T, class... Args>
-   void finish_futures(T& first_futures, Args&... args) {
-      for (auto& future : first_futures)
-         future.get();
-      finish_futures(args...);
-   }
-
-} // namespace {}
+#include <algorithm>
+#include <chrono>
 
 
 template<class T>
-magneto::BufferStructure<T>::BufferStructure(
-   const std::function<T()>& generator_fun, const int max_rng_threads
-)
-   : m_buffer(generator_fun()) // Fill the buffer
-   , m_buffer_filler(generator_fun)
+magneto::BufferStructure<T>::BufferStructure(const Filler& filler, const int ring_size)
+   : m_ring(std::max(ring_size, 2))
+   , m_filler(filler)
 {
-   // Start computing thread(s) for next buffer content immediately
-   m_futures.reserve(max_rng_threads);
-   for (int i = 0; i < max_rng_threads; ++i) {
-      m_futures.emplace_back(std::async(std::launch::async, m_buffer_filler));
-   }
+   // The first buffer is needed right away, the others are filled in the background
+   m_filler(m_ring[0].m_buffer, m_next_buffer_number++);
+   m_ring[0].m_ready = true;
+   for (size_t slot = 1; slot < m_ring.size(); ++slot)
+      submit(slot);
 }
 
 
 template<class T>
 magneto::BufferStructure<T>::~BufferStructure() {
-   // Wait for any running futures to finish
-   finish_futures(m_futures);
+   // Pending fills write into this object
+   std::unique_lock<std::mutex> lock(m_mutex);
+   m_condition.wait(lock, [this] {return m_pending == 0; });
 }
 
 
 template<class T>
 const T& magneto::BufferStructure<T>::get_buffer() const {
-   return m_buffer;
+   return m_ring[m_current].m_buffer;
 }
 
 
 template<class T>
-void magneto::BufferStructure<T>::move_future_results_and_restart(std::future<T>& future) {
-   // fill the buffer with the result of the future
-   m_buffer = std::move(future.get());
-
-   // restart the future to start computing the next one
-   future = std::async(std::launch::async, m_buffer_filler);
+void magneto::BufferStructure<T>::submit(const size_t slot) {
+   const uint32_t buffer_number = m_next_buffer_number++;
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_ring[slot].m_ready = false;
+      ++m_pending;
+   }
+   RngPool::get().submit([this, slot, buffer_number] {
+      // Nobody else touches a slot that isn't ready
+      m_filler(m_ring[slot].m_buffer, buffer_number);
+      // Notify under the lock, the destructor may run as soon as m_pending is 0
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_ring[slot].m_ready = true;
+      --m_pending;
+      m_condition.notify_all();
+   });
 }
 
 
 template<class T>
 void magneto::BufferStructure<T>::refill() {
-   // Find a future that is already finished, or wait for one to finish.
-   // future.is_ready() is ironically not yet in the standard, but it is in MSVC... and pretty neat
+   submit(m_current);
+   m_current = (m_current + 1) % m_ring.size();
 
-   for (auto& future : m_futures) {
-      if (!future._Is_ready())
-         continue;
-
-      move_future_results_and_restart(future);
+   std::unique_lock<std::mutex> lock(m_mutex);
+   if (m_ring[m_current].m_ready)
       return;
-   }
-   auto& future = m_futures.front();
-   move_future_results_and_restart(future);
+   const auto start = std::chrono::steady_clock::now();
+   m_condition.wait(lock, [this] {return m_ring[m_current].m_ready; });
+   const auto blocked = std::chrono::steady_clock::now() - start;
+   RngPool::get().add_starvation(std::chrono::duration_cast<std::chrono::nanoseconds>(blocked).count());
 }
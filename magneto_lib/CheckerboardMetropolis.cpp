@@ -0,0 +1,111 @@
+#include "CheckerboardMetropolis.h"
+#include "IsingSystem.h"
+
+#include <cmath>
+#include <omp.h>
+
+
+namespace {
+
+   /// <summary>Metropolis update of all sites with (i+j)%2 == color. accept(i, j, dE, random) decides
+   /// about uphill moves. Returns the change of the lattice totals.</summary>
+   template<class TAccept>
+   magneto::LatticeTotals update_color(
+      magneto::SpinLattice& lattice,
+      const int color,
+      const int J,
+      const int threads,
+      const magneto::CounterRng& rng,
+      const uint32_t sweep,
+      const TAccept& accept
+   ) {
+      const int Lx = lattice.get_Lx();
+      const int Ly = lattice.get_Ly();
+      int energy_change = 0;
+      int magnetization_change = 0;
+
+      // Halo copies written by set() are only read by sites of the other color, so there are no races
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(+:energy_change, magnetization_change)
+      for (int i = 0; i < Ly; ++i) {
+         for (int j = (i + color) % 2; j < Lx; j += 2) {
+            const int index = lattice.get_index(i, j);
+            const int bond_dE = magneto::get_dE(lattice, index);
+            const int dE = J * bond_dE;
+            if (dE > 0) {
+               const std::array<uint32_t, 4> words = rng.get_words(sweep, i * Lx + j);
+               if (!accept(i, j, dE, magneto::CounterRng::get_uniform(words[0], words[1])))
+                  continue;
+            }
+            energy_change += bond_dE;
+            magnetization_change -= 2 * lattice[index];
+            lattice.set(i, j, -lattice[index]);
+         }
+      }
+      return { energy_change, magnetization_change };
+   }
+
+} // namespace {}
+
+
+int magneto::get_thread_count(const int requested) {
+   if (requested > 0)
+      return requested;
+   return omp_get_num_procs();
+}
+
+
+magneto::CheckerboardMetropolis::CheckerboardMetropolis(
+   const int J, const double T, const int /*Lx*/, const int /*Ly*/, const CounterRng& rng, const int threads /*= 0*/
+)
+   : m_cached_exp_values(get_cached_exp_values(J, T))
+   , m_rng(rng)
+   , m_J(J)
+   , m_threads(get_thread_count(threads))
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::CheckerboardMetropolis::set_temperature(const double T) {
+   m_cached_exp_values = get_cached_exp_values(m_J, T);
+   return true;
+}
+
+
+void magneto::CheckerboardMetropolis::run(SpinLattice& lattice) {
+   const int buffer_offset = m_J > 0 ? 8 * m_J : -8 * m_J;
+   const auto accept = [&](const int /*i*/, const int /*j*/, const int dE, const double random) {
+      return random < m_cached_exp_values[dE + buffer_offset];
+   };
+   add_to_totals(update_color(lattice, 0, m_J, m_threads, m_rng, m_sweep, accept));
+   add_to_totals(update_color(lattice, 1, m_J, m_threads, m_rng, m_sweep, accept));
+   ++m_sweep;
+}
+
+
+magneto::VariableCheckerboardMetropolis::VariableCheckerboardMetropolis(
+   const int J, const LatticeDType& T, const int /*Lx*/, const int /*Ly*/, const CounterRng& rng, const int threads /*= 0*/
+)
+   : m_table(J, T)
+   , m_rng(rng)
+   , m_J(J)
+   , m_threads(get_thread_count(threads))
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::VariableCheckerboardMetropolis::set_temperature_field(const LatticeDType& T) {
+   m_table = TemperatureTable(m_J, T);
+   return true;
+}
+
+
+void magneto::VariableCheckerboardMetropolis::run(SpinLattice& lattice) {
+   const auto accept = [&](const int i, const int j, const int dE, const double random) {
+      return random < m_table.get_probability(i, j, dE);
+   };
+   add_to_totals(update_color(lattice, 0, m_J, m_threads, m_rng, m_sweep, accept));
+   add_to_totals(update_color(lattice, 1, m_J, m_threads, m_rng, m_sweep, accept));
+   ++m_sweep;
+}
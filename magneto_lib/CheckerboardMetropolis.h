@@ -0,0 +1,46 @@
+#pragma once
+
+#include "LatticeAlgorithms.h"
+
+
+namespace magneto {
+
+   /// <summary>Returns requested thread count, or all hardware threads for 0</summary>
+   int get_thread_count(const int requested);
+
+
+   /// <summary>Red/black checkerboard Metropolis that splits every sublattice update across threads
+   /// <para>All sites of one color only have neighbours of the other color, so they can be updated
+   /// concurrently. Rows of a color pass are distributed statically over the OpenMP threads. The
+   /// randoms are counter-based per site and sweep, so the result doesn't depend on the thread
+   /// count. Requires even Lx and Ly.</para>
+   /// </summary>
+   class CLASS_DECLSPEC CheckerboardMetropolis : public LatticeAlgorithm {
+   public:
+      CheckerboardMetropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const int threads = 0);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
+
+   private:
+      std::vector<double> m_cached_exp_values;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
+      int m_J;
+      int m_threads;
+   };
+
+
+   class VariableCheckerboardMetropolis : public LatticeAlgorithm {
+   public:
+      VariableCheckerboardMetropolis(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng, const int threads = 0);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature_field(const LatticeDType& T);
+
+   private:
+      TemperatureTable m_table;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
+      int m_J;
+      int m_threads;
+   };
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+
+namespace magneto {
+
+   /// <summary>Philox4x32-10 block: 128 random bits that are a pure function of counter and key</summary>
+   inline std::array<uint32_t, 4> get_philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+      for (int round = 0; round < 10; ++round) {
+         const uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+         const uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+         counter = {
+            static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+            static_cast<uint32_t>(product1),
+            static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+            static_cast<uint32_t>(product0)
+         };
+         key[0] += 0x9E3779B9u;
+         key[1] += 0xBB67AE85u;
+      }
+      return counter;
+   }
+
+
+   /// <summary>Separates the random numbers of the different stages of one job</summary>
+   enum class RngPhase : uint32_t { Main, Warmup, Exchange };
+
+   /// <summary>How acceptance tests compare randoms: raw 32-bit words against integer thresholds,
+   /// or 53-bit uniform doubles against probabilities</summary>
+   enum class Acceptance { Integer, Double };
+
+   /// <summary>Where the SW randoms come from: buffers filled ahead by the RngPool, or drawn
+   /// inline and only where the outcome depends on them</summary>
+   enum class RandomMode { Buffered, OnDemand };
+
+
+   /// <summary>Counter-based random numbers keyed by (job seed, stream), addressed by (sweep, site)
+   /// <para>The numbers for one site in one sweep don't depend on anything else, so kernels can draw
+   /// them inline, in any order and on any thread. Results are reproducible for a given seed,
+   /// independent of the thread count. The stream separates the temperatures of a job, the phase
+   /// the stages and purpose several uses of the same site within one sweep.</para>
+   /// </summary>
+   class CounterRng {
+   public:
+      CounterRng() = default;
+      CounterRng(const uint64_t seed, const uint32_t stream, const RngPhase phase = RngPhase::Main)
+         : m_key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) }
+         , m_stream(stream)
+         , m_phase(static_cast<uint32_t>(phase) << 16)
+      { }
+
+      [[nodiscard]] std::array<uint32_t, 4> get_words(const uint32_t sweep, const uint32_t site, const uint32_t purpose = 0) const {
+         return get_philox4x32({ site, sweep, m_stream, m_phase | purpose }, m_key);
+      }
+
+      /// <summary>64 bits of this stream to seed the sequential generators of the algorithms that
+      /// consume a varying number of randoms per sweep, like Wolff</summary>
+      [[nodiscard]] uint64_t get_seed() const {
+         const std::array<uint32_t, 4> words = get_words(0, 0, seed_purpose);
+         return (static_cast<uint64_t>(words[0]) << 32) | words[1];
+      }
+
+      /// <summary>Uniform double in [0, 1) with 53 random bits from two words</summary>
+      [[nodiscard]] static double get_uniform(const uint32_t high, const uint32_t low) {
+         return ((static_cast<uint64_t>(high) << 21) ^ (low >> 11)) * (1.0 / 9007199254740992.0);
+      }
+
+      /// <summary>Uniform integer in [0, n) from one word</summary>
+      [[nodiscard]] static uint32_t get_below(const uint32_t word, const uint32_t n) {
+         return static_cast<uint32_t>((static_cast<uint64_t>(word) * n) >> 32);
+      }
+
+      /// <summary>Threshold for a uniform word to be below with the given probability
+      /// <para>Exact up to 2^-32. Probabilities of one and above can't be represented and give the
+      /// largest word, none of the callers need them.</para>
+      /// </summary>
+      [[nodiscard]] static uint32_t get_threshold(const double probability) {
+         if (probability <= 0.0)
+            return 0;
+         if (probability >= 1.0)
+            return std::numeric_limits<uint32_t>::max();
+         return static_cast<uint32_t>(probability * 4294967296.0);
+      }
+
+   private:
+      /// <summary>Purposes are small numbers within a sweep, the seed uses the largest one</summary>
+      static constexpr uint32_t seed_purpose = 0xFFFF;
+
+      std::array<uint32_t, 2> m_key = {};
+      uint32_t m_stream = 0;
+      uint32_t m_phase = 0;
+   };
+}
@@ -22,6 +22,16 @@ magneto::PhysicalMeasurement magneto::operator/(const PhysicalMeasurement& a, co
    return div_result;
 }
 
+bool magneto::operator==(const LatticeTotals& a, const LatticeTotals& b) {
+   return a.energy == b.energy && a.magnetization == b.magnetization;
+}
+
+
+bool magneto::operator!=(const LatticeTotals& a, const LatticeTotals& b) {
+   return !(a == b);
+}
+
+
 magneto::PhysicalMeasurement magneto::get_properties(const IsingSystem& system){
    const double energy = get_E(system.get_lattice());
    const double m = get_m_abs(system.get_lattice());
@@ -29,51 +39,66 @@ magneto::PhysicalMeasurement magneto::get_properties(const IsingSystem& system){
 }
 
 
-__declspec(noinline)
-int magneto::get_dE(const LatticeType& grid, int i, int j){
-   const auto [Lx, Ly] = get_dimensions_of_lattice(grid);
-	return 2 * grid[i][j] * (
-		grid[i][(j + 1) % Lx] +
-		grid[(i + 1) % Ly][j] +
-		grid[i][(j - 1 + Lx) % Lx] +
-		grid[(i - 1 + Ly) % Ly][j]);
+magneto::PhysicalMeasurement magneto::get_properties(const LatticeTotals& totals, const int site_count) {
+   return { totals.energy * 1.0 / site_count, std::abs(totals.magnetization) * 1.0 / site_count };
 }
 
 
-double magneto::get_E(const LatticeType& grid){
-   const auto [Lx, Ly] = get_dimensions_of_lattice(grid);
+double magneto::get_E(const SpinLattice& grid){
+   const int Lx = grid.get_Lx();
+   const int Ly = grid.get_Ly();
+   const int stride = grid.get_stride();
    int E = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j)
-         E += -grid[i][j] * (grid[i][(j + 1) % Lx] + grid[(i + 1) % Ly][j]);
+   for (int i = 0; i < Ly; ++i) {
+      const char* row = grid.data() + grid.get_index(i, 0);
+      for (int j = 0; j < Lx; ++j)
+         E += -row[j] * (row[j + 1] + row[j + stride]);
    }
    return E * 1.0 / (Lx * Ly);
 }
 
 
-double magneto::get_m_abs(const LatticeType& grid){
-   const auto [Lx, Ly] = get_dimensions_of_lattice(grid);
+double magneto::get_m_abs(const SpinLattice& grid){
+   const int Lx = grid.get_Lx();
+   const int Ly = grid.get_Ly();
    int m = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j)
-         m += grid[i][j];
+   for (int i = 0; i < Ly; ++i) {
+      const char* row = grid.data() + grid.get_index(i, 0);
+      for (int j = 0; j < Lx; ++j)
+         m += row[j];
    }
    return std::abs(m) * 1.0 / (Lx * Ly);
 }
 
 
-const magneto::LatticeType& magneto::IsingSystem::get_lattice() const{
+magneto::LatticeTotals magneto::get_lattice_totals(const SpinLattice& grid) {
+   const int Lx = grid.get_Lx();
+   const int Ly = grid.get_Ly();
+   const int stride = grid.get_stride();
+   LatticeTotals totals;
+   for (int i = 0; i < Ly; ++i) {
+      const char* row = grid.data() + grid.get_index(i, 0);
+      for (int j = 0; j < Lx; ++j) {
+         totals.energy += -row[j] * (row[j + 1] + row[j + stride]);
+         totals.magnetization += row[j];
+      }
+   }
+   return totals;
+}
+
+
+const magneto::SpinLattice& magneto::IsingSystem::get_lattice() const{
 	return m_lattice;
 }
 
 
-magneto::LatticeType& magneto::IsingSystem::get_lattice_nc() {
+magneto::SpinLattice& magneto::IsingSystem::get_lattice_nc() {
    return m_lattice;
 }
 
 
 size_t magneto::IsingSystem::get_L() const{
-	return m_lattice.size();
+	return m_lattice.get_Ly();
 }
 
 int magneto::IsingSystem::get_J() const{
@@ -87,9 +112,8 @@ magneto::IsingSystem::IsingSystem(const int j, const magneto::LatticeType& initi
 {}
 
 
-magneto::LatticeType magneto::get_randomized_system(const int Lx, const int Ly) {
-   unsigned seed1 = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-   std::mt19937_64 generator(seed1);
+magneto::LatticeType magneto::get_randomized_system(const int Lx, const int Ly, const uint64_t seed) {
+   std::mt19937_64 generator(seed);
    std::uniform_int_distribution<int> dist(0, 1);
    magneto::LatticeType grid(Ly, std::vector<char>(Lx));
    for (int i = 0; i < Ly; ++i) {
@@ -6,18 +6,20 @@
 #include <optional>
 
 #include "types.h"
+#include "PaddedLattice.h"
+#include "Statistics.h"
 
 namespace magneto {
 	class IsingSystem {
 	public:
       IsingSystem(const int j, const LatticeType& initial_state);
-		[[nodiscard]] const LatticeType& get_lattice() const;
-		[[nodiscard]] LatticeType& get_lattice_nc();
+		[[nodiscard]] const SpinLattice& get_lattice() const;
+		[[nodiscard]] SpinLattice& get_lattice_nc();
 		size_t get_L() const;
       int get_J() const;
 
 	private:
-		LatticeType m_lattice;
+		SpinLattice m_lattice;
 		int m_J = 1;
    };
 
@@ -27,27 +29,53 @@ namespace magneto {
       double magnetization = 0.0;
    };
 
-   /// <summary>Energies and Magnetizations of many system states at one temperature</summary>
+   /// <summary>Energies and Magnetizations of many system states at one temperature
+   /// <para>The statistics are always accumulated, the full time series in measurements only if the
+   /// job keeps it. tau_int is the larger autocorrelation time of energy and magnetization in runs,
+   /// measured at the start of the main iterations.</para>
+   /// </summary>
    struct PhysicalProperties {
+      MeasurementStatistics statistics;
       std::vector<PhysicalMeasurement> measurements;
       double T;
       unsigned int Lx;
       unsigned int Ly;
+      double tau_int = 0.0;
+      uint64_t sweeps = 0;
    };
 
+   /// <summary>Unnormalized energy (in units of J) and magnetization of a lattice</summary>
+   struct LatticeTotals {
+      int energy = 0;
+      int magnetization = 0;
+   };
+   bool operator==(const LatticeTotals& a, const LatticeTotals& b);
+   bool operator!=(const LatticeTotals& a, const LatticeTotals& b);
+
    PhysicalMeasurement operator+(const PhysicalMeasurement& a, const PhysicalMeasurement& b);
    PhysicalMeasurement operator/(const PhysicalMeasurement& a, const unsigned int d);
 
    PhysicalMeasurement get_properties(const IsingSystem& system);
 
-	int get_dE(const LatticeType& grid, int i, int j);
+   /// <summary>Normalized measurement from the totals, without touching the lattice</summary>
+   PhysicalMeasurement get_properties(const LatticeTotals& totals, const int site_count);
+
+   /// <summary>Energy difference (in units of J) of flipping the spin at flat index</summary>
+   inline int get_dE(const SpinLattice& grid, const int index) {
+      const char* spin = grid.data() + index;
+      const int stride = grid.get_stride();
+      return 2 * spin[0] * (spin[1] + spin[stride] + spin[-1] + spin[-stride]);
+   }
 
    /// <summary>Returns normalized energy (per size)</summary>
-   double get_E(const LatticeType& grid);
+   double get_E(const SpinLattice& grid);
 
    /// <summary>Returns normalized absolute magnetization</summary>
-   double get_m_abs(const LatticeType& grid);
+   double get_m_abs(const SpinLattice& grid);
+
+   /// <summary>Energy and magnetization sums in one pass over the lattice</summary>
+   LatticeTotals get_lattice_totals(const SpinLattice& grid);
 
-   LatticeType get_randomized_system(const int Lx, const int Ly);
+   LatticeType get_randomized_system(const int Lx, const int Ly, const uint64_t seed);
 	
 }
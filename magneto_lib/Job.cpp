@@ -3,6 +3,8 @@
 #include "logging.h"
 #include "IsingSystem.h"
 #include "nlohmann/json.hpp"
+#include <algorithm>
+#include <chrono>
 #include <random>
 
 
@@ -13,6 +15,13 @@ namespace {
    }
 
 
+   /// <summary>For values far below the tolerance of is_equal(), like log f or a relative error</summary>
+   bool is_relatively_equal(double a, double b) {
+      constexpr double rel_tol = 1e-9;
+      return fabs(a - b) <= rel_tol * std::max(fabs(a), fabs(b));
+   }
+
+
    bool has_ending(std::string const& fullString, std::string const& ending) {
       if (fullString.length() >= ending.length()) {
          return (0 == fullString.compare(fullString.length() - ending.length(), ending.length(), ending));
@@ -52,6 +61,15 @@ namespace {
          target = j.at(key).get<std::string>();
    }
 
+   template<>
+   void write_value_from_json(const nlohmann::json& j, const char* key, std::vector<std::filesystem::path>& target) {
+      if (!j.contains(key))
+         return;
+      target.clear();
+      for (const std::string& path : j.at(key).get<std::vector<std::string>>())
+         target.emplace_back(path);
+   }
+
 
    /// <summary>Returns vector of n equidistant temperatures</summary>
    std::vector<double> get_temps(
@@ -129,8 +147,14 @@ namespace {
 void magneto::from_json(const nlohmann::json& j, magneto::JsonJob& job) {
    set_enum_from_key(j, job.spin_start_mode, "spin_start", {"random", "image"});
    set_enum_from_key(j, job.temp_mode, "temp", { "single", "range", "image" });
-   set_enum_from_key(j, job.algorithm, "algorithm", { "metropolis", "SW" });
+   set_enum_from_key(j, job.algorithm, "algorithm", { "metropolis", "SW", "metropolis_msc", "metropolis_parallel", "metropolis_simd", "SW_parallel", "wolff" });
+   set_enum_from_key(j, job.acceptance, "acceptance", { "integer", "double" });
+   set_enum_from_key(j, job.random_mode, "random_mode", { "buffered", "on_demand" });
    set_enum_from_key(j, job.image_mode.m_mode, "image_output_mode", { "none", "endimage", "intervals", "movie" });
+   set_enum_from_key(j, job.reweight_config.m_mode, "reweighting", { "none", "single", "multi" });
+   set_enum_from_key(j, job.equilibration, "equilibration", { "fixed", "auto" });
+   set_enum_from_key(j, job.thinning, "thinning", { "none", "auto" });
+   set_enum_from_key(j, job.schedule_config.m_mode, "schedule", { "none", "linear", "exponential", "steps", "images" });
    write_value_from_json(j, "t_min", job.t_min);
    write_value_from_json(j, "t_max", job.t_max);
    write_value_from_json(j, "t", job.t_single);
@@ -142,12 +166,33 @@ void magneto::from_json(const nlohmann::json& j, magneto::JsonJob& job) {
    write_value_from_json(j, "Ly", job.Ly);
    write_value_from_json(j, "J", job.J);
    write_value_from_json(j, "iterations", job.n);
+   write_value_from_json(j, "seed", job.seed);
+   write_value_from_json(j, "threads", job.threads);
+   write_value_from_json(j, "pin_threads", job.pin_threads);
+   write_value_from_json(j, "algorithm_threads", job.algorithm_threads);
+   write_value_from_json(j, "exchange_interval", job.exchange_interval);
+   write_value_from_json(j, "wang_landau", job.wang_landau);
+   write_value_from_json(j, "wang_landau_windows", job.wang_landau_windows);
+   write_value_from_json(j, "wang_landau_log_f", job.wang_landau_log_f);
+   write_value_from_json(j, "keep_time_series", job.keep_time_series);
+   write_value_from_json(j, "continuation", job.continuation);
+   write_value_from_json(j, "target_rel_error", job.target_rel_error);
+   write_value_from_json(j, "max_iterations", job.max_iterations);
    write_value_from_json(j, "spin_start_image_path", job.spin_start_image_path);
    write_value_from_json(j, "image_intervals", job.image_mode.m_intervals);
    write_value_from_json(j, "image_path", job.image_mode.m_path);
    write_value_from_json(j, "fps", job.image_mode.m_fps);
    write_value_from_json(j, "physics_path", job.physics_config.m_outputfile);
    write_value_from_json(j, "physics_format", job.physics_config.m_format);
+   write_value_from_json(j, "reweight_t_min", job.reweight_config.m_t_min);
+   write_value_from_json(j, "reweight_t_max", job.reweight_config.m_t_max);
+   write_value_from_json(j, "reweight_t_steps", job.reweight_config.m_t_steps);
+   write_value_from_json(j, "reweight_path", job.reweight_config.m_outputfile);
+   write_value_from_json(j, "schedule_t_start", job.schedule_config.m_t_start);
+   write_value_from_json(j, "schedule_t_end", job.schedule_config.m_t_end);
+   write_value_from_json(j, "schedule_steps", job.schedule_config.m_steps);
+   write_value_from_json(j, "schedule_images", job.schedule_config.m_images);
+   write_value_from_json(j, "schedule_path", job.schedule_config.m_outputfile);
 }
 
 
@@ -177,7 +222,7 @@ std::optional<T> get_resized_image_state(
 
 
 //magneto::Job
-std::tuple<magneto::Job, std::variant<magneto::LatticeDType, std::vector<double>>>
+std::optional<std::tuple<magneto::Job, std::variant<magneto::LatticeDType, std::vector<double>>>>
 magneto::get_job(const JsonJob& json_job){
    Job job;
 
@@ -202,6 +247,8 @@ magneto::get_job(const JsonJob& json_job){
          json_job.spin_start_image_path,
          fun
       );
+      if (!image_spin_state.has_value())
+         return {};
    }
    if (std::holds_alternative<LatticeDType>(t.value())) {
       const auto fun = [&](const std::filesystem::path path) {return get_lattice_temps_from_png_file(path, json_job.t_min, json_job.t_max); };
@@ -212,21 +259,73 @@ magneto::get_job(const JsonJob& json_job){
          json_job.temperature_image,
          fun
       );
+      if (!t.has_value())
+         return {};
    }
    
+   job.m_seed = json_job.seed;
+   if (job.m_seed == 0)
+      job.m_seed = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+   get_logger()->info("Random seed: {}", job.m_seed);
+
    if (json_job.spin_start_mode == SpinStartMode::Random)
-      job.initial_spins = get_randomized_system(job.m_Lx, job.m_Ly);
+      job.initial_spins = get_randomized_system(job.m_Lx, job.m_Ly, job.m_seed);
    else //SpinStartMode::Image
       job.initial_spins = image_spin_state.value();
 
    job.m_algorithm = json_job.algorithm;
+   job.m_acceptance = json_job.acceptance;
+   job.m_random_mode = json_job.random_mode;
+   job.m_threads = json_job.threads;
+   job.m_pin_threads = json_job.pin_threads;
+   job.m_algorithm_threads = json_job.algorithm_threads;
+   job.m_exchange_interval = json_job.exchange_interval;
+   job.m_wang_landau = json_job.wang_landau;
+   job.m_wang_landau_windows = json_job.wang_landau_windows;
+   job.m_wang_landau_log_f = json_job.wang_landau_log_f;
    job.m_n = json_job.n;
+   job.m_target_rel_error = json_job.target_rel_error;
+   job.m_max_iterations = json_job.max_iterations > 0 ? json_job.max_iterations : json_job.n;
+   // Reweighting needs every sample
+   job.m_keep_time_series = json_job.keep_time_series || json_job.reweight_config.m_mode != Reweighting::None;
    job.m_start_runs = json_job.start_runs;
+   job.m_equilibration = json_job.equilibration;
+   job.m_thinning = json_job.thinning;
+   job.m_continuation = json_job.continuation;
    job.m_J = json_job.J;
    job.m_image_mode = json_job.image_mode;
    job.m_physics_config = json_job.physics_config;
+   job.m_reweight_config = json_job.reweight_config;
+   if (json_job.reweight_config.m_mode != Reweighting::None) {
+      const bool has_range = json_job.reweight_config.m_t_max > json_job.reweight_config.m_t_min;
+      job.m_reweight_temps = get_temps(
+         TempStartMode::Many,
+         has_range ? json_job.reweight_config.m_t_min : json_job.t_min,
+         has_range ? json_job.reweight_config.m_t_max : json_job.t_max,
+         json_job.reweight_config.m_t_steps
+      );
+   }
+   job.m_schedule_config = json_job.schedule_config;
+   const ScheduleConfig& schedule = json_job.schedule_config;
+   const bool uses_schedule_temps = schedule.m_mode == Schedule::Linear || schedule.m_mode == Schedule::Exponential || schedule.m_mode == Schedule::Steps;
+   if (uses_schedule_temps && (schedule.m_t_start <= 0.0 || schedule.m_t_end <= 0.0)) {
+      get_logger()->error("schedule_t_start and schedule_t_end have to be positive, got {} and {}.", schedule.m_t_start, schedule.m_t_end);
+      return {};
+   }
+   if (json_job.schedule_config.m_mode == Schedule::Images) {
+      const auto fun = [&](const std::filesystem::path path) {return get_lattice_temps_from_png_file(path, json_job.t_min, json_job.t_max); };
+      for (const std::filesystem::path& path : json_job.schedule_config.m_images) {
+         const std::optional<LatticeDType> temps = fun(path);
+         if (!temps.has_value())
+            return {};
+         const std::optional<LatticeDType> resized = get_resized_image_state<LatticeDType>(temps.value(), job.m_Lx, job.m_Ly, path, fun);
+         if (!resized.has_value())
+            return {};
+         job.m_schedule_temps.emplace_back(resized.value());
+      }
+   }
 
-   return { job, t.value() };
+   return std::make_tuple(job, t.value());
 }
 
 
@@ -244,17 +343,25 @@ bool magneto::operator==(const ImageMode& a, const ImageMode& b) {
 bool magneto::operator==(const PhysicsConfig& a, const PhysicsConfig& b) {
    return std::tie(a.m_outputfile, a.m_format) == std::tie(b.m_outputfile, b.m_format);
 }
+bool magneto::operator==(const ReweightConfig& a, const ReweightConfig& b) {
+   return std::tie(a.m_mode, a.m_t_steps, a.m_outputfile) == std::tie(b.m_mode, b.m_t_steps, b.m_outputfile)
+      && is_equal(a.m_t_min, b.m_t_min) && is_equal(a.m_t_max, b.m_t_max);
+}
+bool magneto::operator==(const ScheduleConfig& a, const ScheduleConfig& b) {
+   return std::tie(a.m_mode, a.m_steps, a.m_images, a.m_outputfile) == std::tie(b.m_mode, b.m_steps, b.m_images, b.m_outputfile)
+      && is_equal(a.m_t_start, b.m_t_start) && is_equal(a.m_t_end, b.m_t_end);
+}
 
 
 bool magneto::operator==(const JsonJob& a, const JsonJob& b) {
    // use the std::tie trick for most
    if (std::tie(a.spin_start_mode, a.spin_start_image_path, a.temperature_image, a.temp_mode
-         , a.temp_steps, a.start_runs
-         , a.L, a.n, a.algorithm, a.image_mode, a.physics_config)
+         , a.temp_steps, a.start_runs, a.equilibration, a.thinning, a.seed
+         , a.L, a.n, a.algorithm, a.acceptance, a.random_mode, a.threads, a.pin_threads, a.algorithm_threads, a.exchange_interval, a.wang_landau, a.wang_landau_windows, a.keep_time_series, a.continuation, a.max_iterations, a.image_mode, a.physics_config, a.reweight_config, a.schedule_config)
       !=
       std::tie(b.spin_start_mode, b.spin_start_image_path, a.temperature_image, b.temp_mode
-         , b.temp_steps, b.start_runs
-         , b.L, b.n, b.algorithm, b.image_mode, b.physics_config))
+         , b.temp_steps, b.start_runs, b.equilibration, b.thinning, b.seed
+         , b.L, b.n, b.algorithm, b.acceptance, b.random_mode, b.threads, b.pin_threads, b.algorithm_threads, b.exchange_interval, b.wang_landau, b.wang_landau_windows, b.keep_time_series, b.continuation, b.max_iterations, b.image_mode, b.physics_config, b.reweight_config, b.schedule_config))
    {
       return false;
    }
@@ -266,5 +373,9 @@ bool magneto::operator==(const JsonJob& a, const JsonJob& b) {
       return false;
    if (!(is_equal(a.t_max, b.t_max)))
       return false;
+   if (!(is_relatively_equal(a.wang_landau_log_f, b.wang_landau_log_f)))
+      return false;
+   if (!(is_relatively_equal(a.target_rel_error, b.target_rel_error)))
+      return false;
    return true;
 }
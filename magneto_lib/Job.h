@@ -4,17 +4,23 @@
 
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
 #include <filesystem>
 #include <variant>
 #include <optional>
 #include "types.h"
+#include "CounterRng.h"
 
 
 namespace magneto {
-   enum class Algorithm { Metropolis, SW };
+   enum class Algorithm { Metropolis, SW, MultiSpinMetropolis, CheckerboardMetropolis, SimdMetropolis, ParallelSW, Wolff };
    enum class SpinStartMode { Random, Image };
    enum class TempStartMode { Single, Many, Image };
 
+   enum class Reweighting { None, Single, Multi };
+   enum class Equilibration { Fixed, Automatic };
+   enum class Thinning { None, Automatic };
+   enum class Schedule { None, Linear, Exponential, Steps, Images };
    enum class ImageOrMovie { None, Endimage, Intervals, Movie };
    struct ImageMode {
       ImageOrMovie m_mode = ImageOrMovie::Endimage;
@@ -27,6 +33,28 @@ namespace magneto {
       std::filesystem::path m_outputfile = "magneto_results.txt";
       std::string m_format = "T: {T:<5.3f},\tEnergy: {E:<5.3f},\tcv: {cv:<5.3f}, mag: {M:<5.3f}, chi: {chi:<5.3f}";
    };
+
+   /// <summary>Histogram reweighting of the measurements onto a finer temperature grid. Without
+   /// an explicit range, the simulated temperature range is used.</summary>
+   struct ReweightConfig {
+      Reweighting m_mode = Reweighting::None;
+      double m_t_min = 0.0;
+      double m_t_max = 0.0;
+      unsigned int m_t_steps = 100;
+      std::filesystem::path m_outputfile = "magneto_reweighted.txt";
+   };
+
+   /// <summary>Temperature protocol for a single system over the iterations, like a quench or an
+   /// anneal. The temperature goes from t_start to t_end linearly, exponentially or in m_steps equal
+   /// steps. In the Images mode, every image takes an equal share of the iterations instead.</summary>
+   struct ScheduleConfig {
+      Schedule m_mode = Schedule::None;
+      double m_t_start = 0.0;
+      double m_t_end = 0.0;
+      unsigned int m_steps = 10;
+      std::vector<std::filesystem::path> m_images;
+      std::filesystem::path m_outputfile = "magneto_schedule.txt";
+   };
    
 
    struct JsonJob {
@@ -44,21 +72,66 @@ namespace magneto {
       // this only for many temps
       unsigned int temp_steps = 3;
 
-      // How many Swendsen-Wang runs before anything is being recorded/computed
+      // How many runs before anything is being recorded/computed. The upper limit with automatic equilibration
       unsigned int start_runs = 0;
 
+      // Fixed: always start_runs. Automatic: until the energy is stationary
+      Equilibration equilibration = Equilibration::Fixed;
+
+      // None: measure after every run. Automatic: about every 2 tau_int runs
+      Thinning thinning = Thinning::None;
+
       unsigned int L = 0;
       unsigned int Lx = 0;
       unsigned int Ly = 0;
+      // Main sweeps per temperature after the start runs. One run of any algorithm is one sweep
       unsigned int n = 100;
       int J = 1;
 
       // Algorithm used for propagation (after the initial start runs)
       Algorithm algorithm = Algorithm::Metropolis;
 
+      // Seed of all counter-based random numbers. 0 picks one from the clock (and logs it)
+      uint64_t seed = 0;
+
+      // Acceptance test of Metropolis and SW: raw 32-bit randoms against integer thresholds, or doubles
+      Acceptance acceptance = Acceptance::Integer;
+
+      // SW randoms from background-filled buffers or drawn inline where needed
+      RandomMode random_mode = RandomMode::Buffered;
+
+      // Threads of the whole job, split between temperatures, lattices and random numbers. 0 means all hardware threads
+      unsigned int threads = 0;
+      bool pin_threads = true;
+
+      // Threads used within one lattice by the parallel algorithms. 0 leaves it to the thread planner
+      unsigned int algorithm_threads = 0;
+
+      // Sweeps between configuration swaps of neighbouring temperatures. 0 disables them
+      unsigned int exchange_interval = 0;
+
+      // Derive all temperatures from one Wang-Landau density of states instead of simulating each
+      bool wang_landau = false;
+      unsigned int wang_landau_windows = 4;
+      double wang_landau_log_f = 1e-6;
+
+      // Store every measurement besides the running statistics. Reweighting always keeps them
+      bool keep_time_series = false;
+
+      // Start every temperature from the final lattice of the next higher one, in one chain per thread
+      bool continuation = false;
+
+      // Stop every temperature once the relative errors of E and M are below this. 0 runs all n sweeps
+      double target_rel_error = 0.0;
+
+      // Most sweeps of a temperature with a target error. 0 means n
+      unsigned int max_iterations = 0;
+
       ImageMode image_mode;
 
       PhysicsConfig physics_config;
+      ReweightConfig reweight_config;
+      ScheduleConfig schedule_config;
    };
 
 
@@ -69,24 +142,46 @@ namespace magneto {
       int m_J = 1;
       //std::variant<LatticeDType, std::vector<double>> T;
       LatticeType initial_spins;
+      uint64_t m_seed = 0;
       unsigned int m_start_runs = 0;
+      Equilibration m_equilibration = Equilibration::Fixed;
+      Thinning m_thinning = Thinning::None;
 
       // system evolution
       Algorithm m_algorithm = Algorithm::Metropolis;
+      Acceptance m_acceptance = Acceptance::Integer;
+      RandomMode m_random_mode = RandomMode::Buffered;
+      unsigned int m_threads = 0;
+      bool m_pin_threads = true;
+      unsigned int m_algorithm_threads = 0;
+      unsigned int m_exchange_interval = 0;
+      bool m_wang_landau = false;
+      unsigned int m_wang_landau_windows = 4;
+      double m_wang_landau_log_f = 1e-6;
       unsigned int m_n = 100;
+      bool m_keep_time_series = false;
+      bool m_continuation = false;
+      double m_target_rel_error = 0.0;
+      unsigned int m_max_iterations = 100;
 
       // output
       ImageMode m_image_mode;
       PhysicsConfig m_physics_config;
+      ReweightConfig m_reweight_config;
+      std::vector<double> m_reweight_temps;
+      ScheduleConfig m_schedule_config;
+      std::vector<LatticeDType> m_schedule_temps;
    };
 
    CLASS_DECLSPEC bool operator==(const ImageMode& a, const ImageMode& b);
    CLASS_DECLSPEC bool operator==(const PhysicsConfig& a, const PhysicsConfig& b);
+   CLASS_DECLSPEC bool operator==(const ReweightConfig& a, const ReweightConfig& b);
+   CLASS_DECLSPEC bool operator==(const ScheduleConfig& a, const ScheduleConfig& b);
    CLASS_DECLSPEC bool operator==(const JsonJob& a, const JsonJob& b);
 
    void from_json(const nlohmann::json& j, magneto::JsonJob& job);
    CLASS_DECLSPEC JsonJob get_parsed_job(const std::string& file_contents);
-   CLASS_DECLSPEC std::tuple<Job, std::variant<LatticeDType, std::vector<double>>> get_job(const JsonJob& json_job);
+   CLASS_DECLSPEC std::optional<std::tuple<Job, std::variant<LatticeDType, std::vector<double>>>> get_job(const JsonJob& json_job);
    CLASS_DECLSPEC std::optional<JsonJob> get_parsed_job(const std::filesystem::path& path);
 
 }
@@ -1,9 +1,12 @@
 #include "LatticeAlgorithms.h"
 #include "IsingSystem.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
+#include <type_traits>
 
-#include <deque>
 #include "logging.h"
 
 namespace {
@@ -19,290 +22,561 @@ namespace {
       return ss.str();
    }
 
-   struct RandomBufferGetter {
-      RandomBufferGetter(const size_t buffer_size) : m_buffer_size(buffer_size) {};
-      std::vector<double> operator()(){
+   /// <summary>Fills a buffer with uniform randoms, either raw words or doubles. Buffer n of a
+   /// purpose always has the same content, no matter which pool thread fills it.</summary>
+   struct RandomBufferFiller {
+      RandomBufferFiller(const size_t buffer_size, const magneto::CounterRng& rng, const uint32_t purpose)
+         : m_buffer_size(buffer_size), m_rng(rng), m_purpose(purpose) {};
+      void operator()(std::vector<uint32_t>& buffer, const uint32_t buffer_number) const {
          const std::string thread_id = thread_id_to_string(std::this_thread::get_id());
-         unsigned int seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-         std::mt19937_64 rng(seed);
-         std::uniform_real_distribution <double > dist_one(0.0, 1.0);
-         std::vector<double> normal_random_vector;
-         normal_random_vector.reserve(m_buffer_size);
-         for (int i = 0; i < m_buffer_size; ++i)
-            normal_random_vector.emplace_back(dist_one(rng));
-         magneto::get_logger()->debug("get_random_buffer() done from thread {}", thread_id);
-         return normal_random_vector;
+         buffer.resize(m_buffer_size);
+         for (size_t i = 0; i < m_buffer_size; i += 4) {
+            const std::array<uint32_t, 4> words = m_rng.get_words(buffer_number, static_cast<uint32_t>(i / 4), m_purpose);
+            std::copy_n(words.begin(), std::min<size_t>(4, m_buffer_size - i), buffer.begin() + i);
+         }
+         magneto::get_logger()->debug("random buffer {} done from thread {}", buffer_number, thread_id);
+      }
+      void operator()(std::vector<double>& buffer, const uint32_t buffer_number) const {
+         const std::string thread_id = thread_id_to_string(std::this_thread::get_id());
+         buffer.resize(m_buffer_size);
+         for (size_t i = 0; i < m_buffer_size; i += 2) {
+            const std::array<uint32_t, 4> words = m_rng.get_words(buffer_number, static_cast<uint32_t>(i / 2), m_purpose);
+            buffer[i] = magneto::CounterRng::get_uniform(words[0], words[1]);
+            if (i + 1 < m_buffer_size)
+               buffer[i + 1] = magneto::CounterRng::get_uniform(words[2], words[3]);
+         }
+         magneto::get_logger()->debug("random buffer {} done from thread {}", buffer_number, thread_id);
       }
       size_t m_buffer_size;
+      magneto::CounterRng m_rng;
+      uint32_t m_purpose;
    };
 
 
-   struct LatticeIndexGetter {
-      LatticeIndexGetter(const size_t buffer_size, const int Lx, const int Ly) : m_buffer_size(buffer_size), m_Lx(Lx), m_Ly(Ly) {};
-      magneto::IndexPairVector operator()() {
-         const std::string thread_id = thread_id_to_string(std::this_thread::get_id());
-         unsigned int seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-         std::mt19937_64 rng(seed);
-         std::uniform_int_distribution<> dist_lattice_i(0, m_Ly - 1);
-         std::uniform_int_distribution<> dist_lattice_j(0, m_Lx - 1);
-         magneto::IndexPairVector indices;
-         indices.reserve(m_buffer_size);
-         for (int i = 0; i < m_buffer_size; ++i)
-            indices.emplace_back(dist_lattice_i(rng), dist_lattice_j(rng));
-         magneto::get_logger()->debug("get_lattice_indices() done from thread {}", thread_id);
-         return indices;
+   /// <summary>The bound that a random of type TRandom has to be below to hit the probability</summary>
+   template<class TRandom>
+   TRandom get_bound(const double probability);
+
+   template<>
+   double get_bound<double>(const double probability) {
+      return probability;
+   }
+
+   template<>
+   uint32_t get_bound<uint32_t>(const double probability) {
+      return magneto::CounterRng::get_threshold(probability);
+   }
+
+
+   /// <summary>Lx*Ly Metropolis steps. accept(flip_i, flip_j, dE, high, low) decides uphill moves
+   /// with two random words.
+   /// <para>One counter block holds the sites of four steps. The acceptance words are only drawn
+   /// for uphill moves, one block serves two steps and is kept until the next one is needed.</para>
+   /// <para>Returns the change of the lattice totals.</para>
+   /// </summary>
+   template<class TAccept>
+   magneto::LatticeTotals metropolis_sweep(
+      magneto::SpinLattice& lattice,
+      const magneto::CounterRng& rng,
+      const uint32_t sweep,
+      const int J,
+      const TAccept& accept
+   ) {
+      const uint32_t Lx = lattice.get_Lx();
+      const uint32_t site_count = Lx * lattice.get_Ly();
+      std::array<uint32_t, 4> site_words;
+      std::array<uint32_t, 4> accept_words;
+      uint32_t accept_block = std::numeric_limits<uint32_t>::max();
+      // Locals, the char writes to the lattice could alias anything behind a reference
+      int energy_change = 0;
+      int magnetization_change = 0;
+      for (uint32_t step = 0; step < site_count; ++step) {
+         if (step % 4 == 0)
+            site_words = rng.get_words(sweep, step / 4);
+         const uint32_t site = magneto::CounterRng::get_below(site_words[step % 4], site_count);
+         const int flip_i = site / Lx;
+         const int flip_j = site % Lx;
+         const int flip_index = lattice.get_index(flip_i, flip_j);
+         const int bond_dE = magneto::get_dE(lattice, flip_index);
+         const int dE = J * bond_dE;
+         if (dE > 0) {
+            if (step / 2 != accept_block) {
+               accept_block = step / 2;
+               accept_words = rng.get_words(sweep, accept_block, 1);
+            }
+            const uint32_t word = 2 * (step % 2);
+            if (!accept(flip_i, flip_j, dE, accept_words[word], accept_words[word + 1]))
+               continue;
+         }
+         energy_change += bond_dE;
+         magnetization_change -= 2 * lattice[flip_index];
+         lattice.set(flip_i, flip_j, -lattice[flip_index]);
       }
-      size_t m_buffer_size;
-      int m_Lx;
-      int m_Ly;
-   };
+      return { energy_change, magnetization_change };
+   }
+
+
+   int find_root(std::vector<int>& parent, int site) {
+      // Path halving: every visited node is hooked to its grandparent
+      while (parent[site] != site) {
+         parent[site] = parent[parent[site]];
+         site = parent[site];
+      }
+      return site;
+   }
+
+
+   void unite(std::vector<int>& parent, const int a, const int b) {
+      const int root_a = find_root(parent, a);
+      const int root_b = find_root(parent, b);
+      if (root_a < root_b)
+         parent[root_b] = root_a;
+      else if (root_b < root_a)
+         parent[root_a] = root_b;
+   }
+
+
+   /// <summary>One Swendsen-Wang step with union-find (Hoshen-Kopelman style) cluster labelling
+   /// <para>parent and root_flips are the persistent workspace with one entry per site (index i*Lx+j),
+   /// so a step doesn't allocate. Bonds between equal neighbours form if their random is below
+   /// freeze_bound(site). The bond randoms of a site are only requested if one of its bonds can form,
+   /// the flips only for cluster roots.</para>
+   /// <para>Returns the new lattice totals, summed up during the flip pass.</para>
+   /// </summary>
+   template<class TRandoms, class TFreezeBound>
+   magneto::LatticeTotals swendsen_wang_step(
+      magneto::SpinLattice& lattice,
+      std::vector<int>& parent,
+      std::vector<char>& root_flips,
+      TRandoms& randoms,
+      const TFreezeBound& freeze_bound
+   ) {
+      using TRandom = typename TRandoms::value_type;
+      const int Lx = lattice.get_Lx();
+      const int Ly = lattice.get_Ly();
+      const int stride = lattice.get_stride();
+      for (int site = 0; site < Lx * Ly; ++site)
+         parent[site] = site;
+
+      int site = 0;
+      for (int i = 0; i < Ly; ++i) {
+         const char* row = lattice.data() + lattice.get_index(i, 0);
+         for (int j = 0; j < Lx; ++j, ++site) {
+            // Neighbour spins come from the halo, only the labels need the periodic wrap
+            const bool right_aligned = row[j] == row[j + 1];
+            const bool down_aligned = row[j] == row[j + stride];
+            if (!right_aligned && !down_aligned)
+               continue;
+            const TRandom p = freeze_bound(site);
+            const auto [right_random, down_random] = randoms.get_bond_randoms(site);
+            if (right_aligned && right_random < p)
+               unite(parent, site, j + 1 == Lx ? site - j : site + 1);
+            if (down_aligned && down_random < p)
+               unite(parent, site, i + 1 == Ly ? j : site + Lx);
+         }
+      }
+
+      for (site = 0; site < Lx * Ly; ++site) {
+         if (parent[site] == site)
+            root_flips[site] = randoms.get_flip(site);
+      }
+
+      // The bonds of a row are counted once the row below is flipped as well
+      magneto::LatticeTotals totals;
+      site = 0;
+      for (int i = 0; i < Ly; ++i) {
+         char* row = lattice.data() + lattice.get_index(i, 0);
+         for (int j = 0; j < Lx; ++j) {
+            if (root_flips[find_root(parent, site)])
+               row[j] = -row[j];
+            totals.magnetization += row[j];
+            ++site;
+         }
+         if (i > 0)
+            totals.energy += magneto::get_row_energy(row - stride, row, Lx);
+      }
+      totals.energy += magneto::get_row_energy(lattice.data() + lattice.get_index(Ly - 1, 0), lattice.data() + lattice.get_index(0, 0), Lx);
+      lattice.update_halo();
+      return totals;
+   }
+
+   /// <summary>Calls to get_totals() after which tracked totals are checked against a full scan</summary>
+   constexpr unsigned int totals_recompute_interval = 1000;
 
 } // namespace {}
 
 
-magneto::Metropolis::Metropolis(const int J, const double T, const int Lx, const int Ly, const int max_rng_threads)
-   : m_cached_exp_values(get_cached_exp_values(J, T))
+const magneto::LatticeTotals& magneto::LatticeAlgorithm::get_totals(SpinLattice& lattice) {
+   write_back(lattice);
+   if (!m_tracks_totals || !m_totals_valid) {
+      m_totals = get_lattice_totals(lattice);
+      m_totals_valid = true;
+      m_calls_since_recompute = 0;
+   }
+   else if (++m_calls_since_recompute >= totals_recompute_interval) {
+      const LatticeTotals scanned = get_lattice_totals(lattice);
+      if (scanned != m_totals) {
+         get_logger()->warn(
+            "Tracked totals drifted to E={}, M={} instead of E={}, M={}. Resetting them.",
+            m_totals.energy, m_totals.magnetization, scanned.energy, scanned.magnetization
+         );
+      }
+      m_totals = scanned;
+      m_calls_since_recompute = 0;
+   }
+   return m_totals;
+}
+
+
+void magneto::LatticeAlgorithm::reset_totals() {
+   m_totals_valid = false;
+}
+
+
+void magneto::LatticeAlgorithm::write_back(SpinLattice& /*lattice*/) {
+}
+
+
+bool magneto::LatticeAlgorithm::set_temperature(const double /*T*/) {
+   return false;
+}
+
+
+bool magneto::LatticeAlgorithm::set_temperature_field(const LatticeDType& /*T*/) {
+   return false;
+}
+
+
+void magneto::LatticeAlgorithm::set_tracks_totals() {
+   m_tracks_totals = true;
+}
+
+
+void magneto::LatticeAlgorithm::add_to_totals(const LatticeTotals& change) {
+   // Changes before the first get_totals() don't matter, that one scans the lattice anyway
+   m_totals.energy += change.energy;
+   m_totals.magnetization += change.magnetization;
+}
+
+
+void magneto::LatticeAlgorithm::set_totals(const LatticeTotals& totals) {
+   m_totals = totals;
+   m_totals_valid = true;
+}
+
+
+magneto::Metropolis::Metropolis(
+   const int J, const double T, const int /*Lx*/, const int /*Ly*/, const CounterRng& rng, const Acceptance acceptance
+)
+   : m_acceptance(acceptance)
+   , m_rng(rng)
    , m_J(J)
-   , m_lattice_index_buffer(LatticeIndexGetter(Lx*Ly, Lx, Ly), max_rng_threads)
-   , m_random_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-{ }
+{
+   set_tracks_totals();
+   set_temperature(T);
+}
+
+
+bool magneto::Metropolis::set_temperature(const double T) {
+   m_cached_exp_values = get_cached_exp_values(m_J, T);
+   m_cached_thresholds.clear();
+   for (const double probability : m_cached_exp_values)
+      m_cached_thresholds.emplace_back(CounterRng::get_threshold(probability));
+   return true;
+}
+
+
+magneto::TemperatureTable::TemperatureTable(const int J, const LatticeDType& T)
+   : m_Lx(static_cast<int>(T[0].size()))
+   , m_dE_step(std::max(4 * std::abs(J), 1))
+{
+   constexpr size_t max_levels = 256;
+   std::vector<double> temps;
+   for (const std::vector<double>& row : T)
+      temps.insert(temps.end(), row.cbegin(), row.cend());
+   std::vector<double> levels = temps;
+   std::sort(levels.begin(), levels.end());
+   levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+   m_site_levels.reserve(temps.size());
+   if (levels.size() <= max_levels) {
+      for (const double t : temps)
+         m_site_levels.emplace_back(static_cast<uint8_t>(std::lower_bound(levels.cbegin(), levels.cend(), t) - levels.cbegin()));
+   }
+   else {
+      get_logger()->warn("Temperature field has {} distinct values, rounding them to {} levels.", levels.size(), max_levels);
+      const double t_min = levels.front();
+      const double level_width = (levels.back() - t_min) / (max_levels - 1);
+      levels.resize(max_levels);
+      for (size_t level = 0; level < max_levels; ++level)
+         levels[level] = t_min + level * level_width;
+      for (const double t : temps)
+         m_site_levels.emplace_back(static_cast<uint8_t>(std::lround((t - t_min) / level_width)));
+   }
+
+   for (const double t : levels) {
+      for (int column = 0; column < 5; ++column) {
+         const double probability = std::min(1.0, exp(-(column - 2) * m_dE_step / t));
+         m_probabilities.emplace_back(probability);
+         m_thresholds.emplace_back(CounterRng::get_threshold(probability));
+      }
+   }
+}
 
 
 magneto::VariableMetropolis::VariableMetropolis(
-   const int J, const LatticeDType& T, const int Lx, const int Ly, const int max_rng_threads /*= 2*/
+   const int J, const LatticeDType& T, const int /*Lx*/, const int /*Ly*/, const CounterRng& rng, const Acceptance acceptance
 )
-   : m_J(J)
-   , m_lattice_index_buffer(LatticeIndexGetter(Lx*Ly, Lx, Ly), max_rng_threads)
-   , m_random_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_T(T)
-{ }
+   : m_table(J, T)
+   , m_acceptance(acceptance)
+   , m_rng(rng)
+   , m_J(J)
+{
+   set_tracks_totals();
+}
 
 
-void magneto::VariableMetropolis::run(LatticeType& lattice){
-   int flip_i, flip_j;
-   int dE;
-   for (int i = 0; i < m_random_buffer.get_buffer().size(); ++i) {
-      flip_i = m_lattice_index_buffer.get_buffer()[i].first;
-      flip_j = m_lattice_index_buffer.get_buffer()[i].second;
-      dE = m_J * get_dE(lattice, flip_i, flip_j);
-      const double exp_value = exp(-dE / m_T[flip_i][flip_j]);
-      if (dE <= 0 || (m_random_buffer.get_buffer()[i] < exp_value))
-         lattice[flip_i][flip_j] *= -1;
-   }
+bool magneto::VariableMetropolis::set_temperature_field(const LatticeDType& T) {
+   m_table = TemperatureTable(m_J, T);
+   return true;
+}
+
 
-   m_random_buffer.refill();
-   m_lattice_index_buffer.refill();
+void magneto::VariableMetropolis::run(SpinLattice& lattice){
+   if (m_acceptance == Acceptance::Integer) {
+      add_to_totals(metropolis_sweep(lattice, m_rng, m_sweep, m_J,
+         [&](const int flip_i, const int flip_j, const int dE, const uint32_t high, const uint32_t /*low*/) {
+            return high < m_table.get_threshold(flip_i, flip_j, dE);
+         }
+      ));
+   }
+   else {
+      add_to_totals(metropolis_sweep(lattice, m_rng, m_sweep, m_J,
+         [&](const int flip_i, const int flip_j, const int dE, const uint32_t high, const uint32_t low) {
+            return CounterRng::get_uniform(high, low) < m_table.get_probability(flip_i, flip_j, dE);
+         }
+      ));
+   }
+   ++m_sweep;
 }
 
-void magneto::Metropolis::run(LatticeType& lattice){
+void magneto::Metropolis::run(SpinLattice& lattice){
    const int buffer_offset = get_exp_buffer_offset(m_J);
-   int flip_i, flip_j;
-   int dE;
-   for (int i = 0; i < m_random_buffer.get_buffer().size(); ++i) {
-      flip_i = m_lattice_index_buffer.get_buffer()[i].first;
-      flip_j = m_lattice_index_buffer.get_buffer()[i].second;
-      dE = m_J * get_dE(lattice, flip_i, flip_j);
-      if (dE <= 0 || (m_random_buffer.get_buffer()[i] < m_cached_exp_values[dE + buffer_offset]))
-         lattice[flip_i][flip_j] *= -1;
+   if (m_acceptance == Acceptance::Integer) {
+      add_to_totals(metropolis_sweep(lattice, m_rng, m_sweep, m_J,
+         [&](const int /*flip_i*/, const int /*flip_j*/, const int dE, const uint32_t high, const uint32_t /*low*/) {
+            return high < m_cached_thresholds[dE + buffer_offset];
+         }
+      ));
    }
-
-   m_random_buffer.refill();
-   m_lattice_index_buffer.refill();
+   else {
+      add_to_totals(metropolis_sweep(lattice, m_rng, m_sweep, m_J,
+         [&](const int /*flip_i*/, const int /*flip_j*/, const int dE, const uint32_t high, const uint32_t low) {
+            return CounterRng::get_uniform(high, low) < m_cached_exp_values[dE + buffer_offset];
+         }
+      ));
+   }
+   ++m_sweep;
 }
 
 
 std::vector<double> magneto::get_cached_exp_values(const int J, const double T) {
    std::vector<double> exp_values;
-   const int min_value = -8 * J;
-   const int max_value = 8 * J;
-   const int value_count = max_value - min_value + 1;
+   // dE = J*get_dE() is within [-8|J|, 8|J|] for either sign of J
    const int buffer_offset = get_exp_buffer_offset(J);
+   const int value_count = 2 * buffer_offset + 1;
    for (int dE = 0; dE < value_count; ++dE)
       exp_values.push_back(exp(-(dE - buffer_offset) / T));
    return exp_values;
 }
 
 
-magneto::SW::SW(const int J, const double T, const int Lx, const int Ly, const int max_rng_threads)
-   : m_J(J)
-   , m_T(T)
-   , m_bond_north_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_bond_east_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_flip_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
+template<class TRandom>
+magneto::SWBufferedRandoms<TRandom>::SWBufferedRandoms(const int site_count, const CounterRng& rng, const int ring_size)
+   : m_bond_north(RandomBufferFiller(site_count, rng, 0), ring_size)
+   , m_bond_east(RandomBufferFiller(site_count, rng, 1), ring_size)
+   , m_flip(RandomBufferFiller(site_count, rng, 2), ring_size)
 { }
 
 
-void magneto::SW::run(LatticeType& lattice){
-   const double freezeProbability = 1.0 - exp(-2.0f * m_J / m_T);
+template<class TRandom>
+std::pair<TRandom, TRandom> magneto::SWBufferedRandoms<TRandom>::get_bond_randoms(const int site) const {
+   return { m_bond_north.get_buffer()[site], m_bond_east.get_buffer()[site] };
+}
 
-   LatticeType discovered;
-   LatticeType doesBondNorth;
-   LatticeType doesBondEast;
 
-   //const int L = static_cast<int>(lattice.size());
-   bool flipCluster;
-   int deq_i, deq_j, deq_i_adj, deq_j_adj;
-   const auto [Lx, Ly] = get_dimensions_of_lattice(lattice);
-   discovered.assign(Ly, std::vector<char>(Lx, 0));
-   doesBondNorth.assign(Ly, std::vector<char>(Lx, 0));
-   doesBondEast.assign(Ly, std::vector<char>(Lx, 0));
+template<class TRandom>
+bool magneto::SWBufferedRandoms<TRandom>::get_flip(const int site) const {
+   return m_flip.get_buffer()[site] < get_bound<TRandom>(0.5);
+}
 
-   int counter = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j) {
-         doesBondNorth[i][j] = m_bond_north_buffer.get_buffer()[counter] < freezeProbability;
-         doesBondEast[i][j] = m_bond_east_buffer.get_buffer()[counter] < freezeProbability;
-         ++counter;
-      }
+
+template<class TRandom>
+void magneto::SWBufferedRandoms<TRandom>::advance() {
+   m_bond_north.refill();
+   m_bond_east.refill();
+   m_flip.refill();
+}
+
+
+template<class TRandom>
+magneto::SWOnDemandRandoms<TRandom>::SWOnDemandRandoms(const CounterRng& rng)
+   : m_rng(rng)
+{ }
+
+
+template<class TRandom>
+std::pair<TRandom, TRandom> magneto::SWOnDemandRandoms<TRandom>::get_bond_randoms(const int site) {
+   // Integer randoms need one word per bond, so a block serves two sites
+   constexpr int sites_per_block = std::is_same_v<TRandom, uint32_t> ? 2 : 1;
+   const uint32_t block = site / sites_per_block;
+   if (block != m_bond_block) {
+      m_bond_block = block;
+      m_bond_words = m_rng.get_words(m_sweep, block);
    }
+   if constexpr (std::is_same_v<TRandom, uint32_t>) {
+      const int word = 2 * (site % 2);
+      return { m_bond_words[word], m_bond_words[word + 1] };
+   }
+   else
+      return { CounterRng::get_uniform(m_bond_words[0], m_bond_words[1]), CounterRng::get_uniform(m_bond_words[2], m_bond_words[3]) };
+}
 
-   counter = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j) {
-         if (!discovered[i][j]) {
-            flipCluster = m_flip_buffer.get_buffer()[counter] < 0.5;
-            std::deque<std::tuple<int, int>> deq(1, std::make_tuple(i, j));
-            discovered[i][j] = 1;
-
-            while (!deq.empty()) {
-               deq_i = std::get<0>(deq.front());
-               deq_j = std::get<1>(deq.front());
-
-               deq_i_adj = deq_i;
-               deq_j_adj = (deq_j + 1) % Lx;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondNorth[deq_i][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = (deq_i + 1) % Ly;
-               deq_j_adj = deq_j;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondEast[deq_i][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = deq_i;
-               deq_j_adj = (deq_j - 1 + Lx) % Lx;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondNorth[deq_i][deq_j_adj]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = (deq_i - 1 + Ly) % Ly;
-               deq_j_adj = deq_j;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondEast[deq_i_adj][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               if (flipCluster)
-                  lattice[deq_i][deq_j] *= -1;
-               deq.pop_front();
-            }
-         }
-         ++counter;
+
+template<class TRandom>
+bool magneto::SWOnDemandRandoms<TRandom>::get_flip(const int site) {
+   // A flip is one random bit, a block covers 128 sites
+   const uint32_t block = site / 128;
+   if (block != m_flip_block) {
+      m_flip_block = block;
+      m_flip_words = m_rng.get_words(m_sweep, block, 1);
+   }
+   const int bit = site % 128;
+   return (m_flip_words[bit / 32] >> (bit % 32)) & 1u;
+}
+
+
+template<class TRandom>
+void magneto::SWOnDemandRandoms<TRandom>::advance() {
+   ++m_sweep;
+   m_bond_block = std::numeric_limits<uint32_t>::max();
+   m_flip_block = std::numeric_limits<uint32_t>::max();
+}
+
+template struct magneto::SWBufferedRandoms<uint32_t>;
+template struct magneto::SWBufferedRandoms<double>;
+template struct magneto::SWOnDemandRandoms<uint32_t>;
+template struct magneto::SWOnDemandRandoms<double>;
+
+
+namespace {
+   magneto::SWRandomVariant get_sw_randoms(
+      const int site_count,
+      const magneto::CounterRng& rng,
+      const magneto::Acceptance acceptance,
+      const magneto::RandomMode random_mode,
+      const int ring_size
+   ) {
+      using namespace magneto;
+      const bool integer = acceptance == Acceptance::Integer;
+      if (random_mode == RandomMode::OnDemand) {
+         if (integer)
+            return SWRandomVariant(std::in_place_type<SWOnDemandRandoms<uint32_t>>, rng);
+         return SWRandomVariant(std::in_place_type<SWOnDemandRandoms<double>>, rng);
       }
+      if (integer)
+         return SWRandomVariant(std::in_place_type<SWBufferedRandoms<uint32_t>>, site_count, rng, ring_size);
+      return SWRandomVariant(std::in_place_type<SWBufferedRandoms<double>>, site_count, rng, ring_size);
    }
+}
+
+
+magneto::SW::SW(
+   const int J, const double T, const int Lx, const int Ly, const CounterRng& rng,
+   const Acceptance acceptance, const RandomMode random_mode, const int ring_size
+)
+   : m_randoms(get_sw_randoms(Lx*Ly, rng, acceptance, random_mode, ring_size))
+   , m_labels(Lx*Ly)
+   , m_root_flips(Lx*Ly)
+   , m_freeze_probability(get_freeze_probability(J, T))
+   , m_J(J)
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::SW::set_temperature(const double T) {
+   m_freeze_probability = get_freeze_probability(m_J, T);
+   return true;
+}
 
-   m_bond_north_buffer.refill();
-   m_bond_east_buffer.refill();
-   m_flip_buffer.refill();
+
+void magneto::SW::run(SpinLattice& lattice){
+   std::visit([&](auto& randoms) {
+      using TRandom = typename std::decay_t<decltype(randoms)>::value_type;
+      const TRandom freeze_bound = get_bound<TRandom>(m_freeze_probability);
+      set_totals(swendsen_wang_step(lattice, m_labels, m_root_flips, randoms, [&](const int /*site*/) {return freeze_bound; }));
+      randoms.advance();
+   }, m_randoms);
 }
 
 
-magneto::LatticeDType get_freeze_probability(const int Lx, const int Ly, const int J, const magneto::LatticeDType& temps) {
-   magneto::LatticeDType probabilities(Ly, std::vector<double>(Lx));
+double magneto::get_freeze_probability(const int J, const double T) {
+   return 1.0 - exp(-2.0f * J / T);
+}
+
+
+std::vector<double> magneto::get_freeze_probability(const int Lx, const int Ly, const int J, const magneto::LatticeDType& temps) {
+   std::vector<double> probabilities;
+   probabilities.reserve(Lx * Ly);
    for (int i = 0; i < Ly; ++i) {
       for (int j = 0; j < Lx; ++j) {
-         probabilities[i][j] = 1.0 - exp(-2.0f * J / temps[i][j]);
+         probabilities.emplace_back(get_freeze_probability(J, temps[i][j]));
       }
    }
    return probabilities;
 }
 
 
-magneto::VariableSW::VariableSW(const int J, const LatticeDType& T, const int Lx, const int Ly, const int max_rng_threads)
-   : m_J(J)
-   , m_bond_north_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_bond_east_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_flip_buffer(RandomBufferGetter(Lx*Ly), max_rng_threads)
-   , m_freeze_probability(get_freeze_probability(Lx, Ly, J, T))
-{ }
+int magneto::get_row_energy(const char* row, const char* row_below, const int Lx) {
+   int energy = -row[Lx - 1] * (row[0] + row_below[Lx - 1]);
+   for (int j = 0; j + 1 < Lx; ++j)
+      energy -= row[j] * (row[j + 1] + row_below[j]);
+   return energy;
+}
 
 
-void magneto::VariableSW::run(LatticeType& lattice) {
-   LatticeType discovered;
-   LatticeType doesBondNorth;
-   LatticeType doesBondEast;
-
-   bool flipCluster;
-   const auto [Lx, Ly] = get_dimensions_of_lattice(lattice);
-   int deq_i, deq_j, deq_i_adj, deq_j_adj;
-   discovered.assign(Ly, std::vector<char>(Lx, 0));
-   doesBondNorth.assign(Ly, std::vector<char>(Lx, 0));
-   doesBondEast.assign(Ly, std::vector<char>(Lx, 0));
-
-   int counter = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j) {
-         doesBondNorth[i][j] = m_bond_north_buffer.get_buffer()[counter] < m_freeze_probability[i][j];
-         doesBondEast[i][j] = m_bond_east_buffer.get_buffer()[counter] < m_freeze_probability[i][j];
-         ++counter;
-      }
-   }
+magneto::VariableSW::VariableSW(
+   const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng,
+   const Acceptance acceptance, const RandomMode random_mode, const int ring_size
+)
+   : m_randoms(get_sw_randoms(Lx*Ly, rng, acceptance, random_mode, ring_size))
+   , m_labels(Lx*Ly)
+   , m_root_flips(Lx*Ly)
+   , m_J(J)
+{
+   set_tracks_totals();
+   set_temperature_field(T);
+}
 
-   counter = 0;
-   for (unsigned int i = 0; i < Ly; ++i) {
-      for (unsigned int j = 0; j < Lx; ++j) {
-         if (!discovered[i][j]) {
-            flipCluster = m_flip_buffer.get_buffer()[counter] < 0.5;
-            std::deque<std::tuple<int, int>> deq(1, std::make_tuple(i, j));
-            discovered[i][j] = 1;
-
-            while (!deq.empty()) {
-               deq_i = std::get<0>(deq.front());
-               deq_j = std::get<1>(deq.front());
-
-               deq_i_adj = deq_i;
-               deq_j_adj = (deq_j + 1) % Lx;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondNorth[deq_i][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = (deq_i + 1) % Ly;
-               deq_j_adj = deq_j;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondEast[deq_i][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = deq_i;
-               deq_j_adj = (deq_j - 1 + Lx) % Lx;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondNorth[deq_i][deq_j_adj]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               deq_i_adj = (deq_i - 1 + Ly) % Ly;
-               deq_j_adj = deq_j;
-               if (lattice[deq_i][deq_j] == lattice[deq_i_adj][deq_j_adj] && discovered[deq_i_adj][deq_j_adj] == 0 && doesBondEast[deq_i_adj][deq_j]) {
-                  deq.push_back(std::make_tuple(deq_i_adj, deq_j_adj));
-                  discovered[deq_i_adj][deq_j_adj] = 1;
-               }
-
-               if (flipCluster)
-                  lattice[deq_i][deq_j] *= -1;
-               deq.pop_front();
-            }
-         }
-         ++counter;
-      }
-   }
 
-   m_bond_north_buffer.refill();
-   m_bond_east_buffer.refill();
-   m_flip_buffer.refill();
+bool magneto::VariableSW::set_temperature_field(const LatticeDType& T) {
+   const auto [Lx, Ly] = get_dimensions_of_lattice(T);
+   m_freeze_probability = get_freeze_probability(Lx, Ly, m_J, T);
+   m_freeze_thresholds.clear();
+   for (const double probability : m_freeze_probability)
+      m_freeze_thresholds.emplace_back(CounterRng::get_threshold(probability));
+   return true;
 }
 
+
+void magneto::VariableSW::run(SpinLattice& lattice) {
+   std::visit([&](auto& randoms) {
+      using TRandom = typename std::decay_t<decltype(randoms)>::value_type;
+      if constexpr (std::is_same_v<TRandom, uint32_t>)
+         set_totals(swendsen_wang_step(lattice, m_labels, m_root_flips, randoms, [&](const int site) {return m_freeze_thresholds[site]; }));
+      else
+         set_totals(swendsen_wang_step(lattice, m_labels, m_root_flips, randoms, [&](const int site) {return m_freeze_probability[site]; }));
+      randoms.advance();
+   }, m_randoms);
+}
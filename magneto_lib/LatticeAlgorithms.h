@@ -1,68 +1,200 @@
 #pragma once
 
+#include "export_macro.h"
 #include "types.h"
+#include "IsingSystem.h"
+#include "PaddedLattice.h"
 #include "BufferStructure.h"
+#include "CounterRng.h"
+
+#include <variant>
 
 
 namespace magneto {
 
-   class LatticeAlgorithm {
+   /// <summary>Base of all algorithms, one run() is one sweep
+   /// <para>Algorithms that know what their flips change keep running energy and magnetization
+   /// totals of the lattice, so a measurement doesn't need to scan it. They enable that with
+   /// set_tracks_totals() and update the totals in run() with add_to_totals() or set_totals().</para>
+   /// </summary>
+   class CLASS_DECLSPEC LatticeAlgorithm {
    public:
-      virtual void run(LatticeType& lattice) = 0;
+      virtual ~LatticeAlgorithm() = default;
+      virtual void run(SpinLattice& lattice) = 0;
+
+      /// <summary>Totals of the lattice that was last passed to run(), written back first
+      /// <para>The lattice is only scanned if the totals aren't tracked or not known yet, and every
+      /// totals_recompute_interval calls to catch drift.</para>
+      /// </summary>
+      [[nodiscard]] const LatticeTotals& get_totals(SpinLattice& lattice);
+
+      /// <summary>Brings the lattice up to date for algorithms that keep the spins in their own
+      /// representation between runs. Needed before the lattice is read by anything else.</summary>
+      virtual void write_back(SpinLattice& lattice);
+
+      /// <summary>Needed after the lattice was changed by anything but run(). Algorithms that keep
+      /// the spins in their own representation drop it, so write_back() first to keep their sweeps.</summary>
+      virtual void reset_totals();
+
+      /// <summary>Changes the temperature between two runs. Only the lookup tables are rebuilt, buffers
+      /// and random state are kept. Returns false if the algorithm can't, it has to be constructed
+      /// again then.</summary>
+      virtual bool set_temperature(const double T);
+      virtual bool set_temperature_field(const LatticeDType& T);
+
+   protected:
+      void set_tracks_totals();
+      void add_to_totals(const LatticeTotals& change);
+      void set_totals(const LatticeTotals& totals);
+
+   private:
+      LatticeTotals m_totals;
+      bool m_tracks_totals = false;
+      bool m_totals_valid = false;
+      unsigned int m_calls_since_recompute = 0;
    };
 
+   /// <summary>Temperature field quantized to at most 256 levels, with the Metropolis acceptance of
+   /// every level and energy change in a table
+   /// <para>Temperature images have 256 grey levels, so this is exact for them. Other fields with
+   /// more distinct temperatures are rounded to 256 equidistant levels. Every site only keeps its
+   /// level, and the five columns belong to the single flip energy changes -8|J| to 8|J|. With J=0
+   /// every change is 0, and lands in the middle column.</para>
+   /// </summary>
+   class CLASS_DECLSPEC TemperatureTable {
+   public:
+      TemperatureTable(const int J, const LatticeDType& T);
+
+      [[nodiscard]] uint32_t get_threshold(const int i, const int j, const int dE) const {
+         return m_thresholds[get_entry(i, j, dE)];
+      }
+
+      [[nodiscard]] double get_probability(const int i, const int j, const int dE) const {
+         return m_probabilities[get_entry(i, j, dE)];
+      }
+
+   private:
+      [[nodiscard]] size_t get_entry(const int i, const int j, const int dE) const {
+         return m_site_levels[i * m_Lx + j] * 5 + dE / m_dE_step + 2;
+      }
+
+      std::vector<uint8_t> m_site_levels;
+      std::vector<uint32_t> m_thresholds;
+      std::vector<double> m_probabilities;
+      int m_Lx;
+      int m_dE_step;
+   };
+
+
+   /// <summary>Metropolis with Lx*Ly randomly chosen sites per run. Site and acceptance random come
+   /// from counter-based blocks, acceptance words are only drawn for uphill moves.
+   /// <para>With integer acceptance, the acceptance probabilities are cached as 32-bit thresholds and
+   /// compared against a raw random word, the double path builds a 53-bit uniform from two words.</para>
+   /// </summary>
    class Metropolis : public LatticeAlgorithm {
    public:
-      Metropolis(const int J, const double T, const int Lx, const int Ly, const int max_rng_threads = 2);
-      virtual void run(LatticeType& lattice);
+      Metropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const Acceptance acceptance = Acceptance::Integer);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
 
    private:
-      BufferStructure<IndexPairVector> m_lattice_index_buffer;
-      BufferStructure<std::vector<double>> m_random_buffer;
       std::vector<double> m_cached_exp_values;
+      std::vector<uint32_t> m_cached_thresholds;
+      Acceptance m_acceptance;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
       int m_J;
    };
 
 
+   /// <summary>Metropolis with a temperature per site, looked up in a TemperatureTable</summary>
    class VariableMetropolis : public LatticeAlgorithm {
    public:
-      VariableMetropolis(const int J, const LatticeDType& T, const int Lx, const int Ly, const int max_rng_threads = 2);
-      virtual void run(LatticeType& lattice);
+      VariableMetropolis(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng, const Acceptance acceptance = Acceptance::Integer);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature_field(const LatticeDType& T);
 
    private:
-      BufferStructure<IndexPairVector> m_lattice_index_buffer;
-      BufferStructure<std::vector<double>> m_random_buffer;
-      const LatticeDType m_T;
+      TemperatureTable m_table;
+      Acceptance m_acceptance;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
       int m_J;
    };
 
 
-   class SW : public LatticeAlgorithm {
+   /// <summary>Bond and flip randoms of one SW step, each buffer refilled in the background
+   /// <para>TRandom is uint32_t for the integer acceptance path, which halves the buffer memory and
+   /// bandwidth compared to double.</para>
+   /// </summary>
+   template<class TRandom>
+   struct SWBufferedRandoms {
+      using value_type = TRandom;
+      SWBufferedRandoms(const int site_count, const CounterRng& rng, const int ring_size);
+      [[nodiscard]] std::pair<TRandom, TRandom> get_bond_randoms(const int site) const;
+      [[nodiscard]] bool get_flip(const int site) const;
+      void advance();
+
+      BufferStructure<std::vector<TRandom>> m_bond_north;
+      BufferStructure<std::vector<TRandom>> m_bond_east;
+      BufferStructure<std::vector<TRandom>> m_flip;
+   };
+
+
+   /// <summary>SW randoms drawn inline from the counter-based generator, only where the step asks
+   /// for them: sites with at least one aligned neighbour and cluster roots. Nothing is computed
+   /// ahead. The step asks in site order, so the last block is kept for the neighbouring sites.</summary>
+   template<class TRandom>
+   struct SWOnDemandRandoms {
+      using value_type = TRandom;
+      explicit SWOnDemandRandoms(const CounterRng& rng);
+      [[nodiscard]] std::pair<TRandom, TRandom> get_bond_randoms(const int site);
+      [[nodiscard]] bool get_flip(const int site);
+      void advance();
+
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
+      uint32_t m_bond_block = std::numeric_limits<uint32_t>::max();
+      uint32_t m_flip_block = std::numeric_limits<uint32_t>::max();
+      std::array<uint32_t, 4> m_bond_words = {};
+      std::array<uint32_t, 4> m_flip_words = {};
+   };
+   using SWRandomVariant = std::variant<
+      SWBufferedRandoms<uint32_t>, SWBufferedRandoms<double>, SWOnDemandRandoms<uint32_t>, SWOnDemandRandoms<double>
+   >;
+
+
+   class CLASS_DECLSPEC SW : public LatticeAlgorithm {
    public:
-      SW(const int J, const double T, const int Lx, const int Ly, const int max_rng_threads = 1);
-      virtual void run(LatticeType& lattice);
+      SW(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng,
+         const Acceptance acceptance = Acceptance::Integer, const RandomMode random_mode = RandomMode::Buffered, const int ring_size = 2
+      );
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
 
    private:
-      BufferStructure<std::vector<double>> m_bond_north_buffer;
-      BufferStructure<std::vector<double>> m_bond_east_buffer;
-      BufferStructure<std::vector<double>> m_flip_buffer;
-
+      SWRandomVariant m_randoms;
+      std::vector<int> m_labels;
+      std::vector<char> m_root_flips;
+      double m_freeze_probability;
       int m_J;
-      double m_T;
    };
 
 
    class VariableSW : public LatticeAlgorithm {
    public:
-      VariableSW(const int J, const LatticeDType& T, const int Lx, const int Ly, const int max_rng_threads = 1);
-      virtual void run(LatticeType& lattice);
+      VariableSW(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng,
+         const Acceptance acceptance = Acceptance::Integer, const RandomMode random_mode = RandomMode::Buffered, const int ring_size = 2
+      );
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature_field(const LatticeDType& T);
 
    private:
-      BufferStructure<std::vector<double>> m_bond_north_buffer;
-      BufferStructure<std::vector<double>> m_bond_east_buffer;
-      BufferStructure<std::vector<double>> m_flip_buffer;
-      LatticeDType m_freeze_probability;
-
+      SWRandomVariant m_randoms;
+      std::vector<double> m_freeze_probability;
+      std::vector<uint32_t> m_freeze_thresholds;
+      std::vector<int> m_labels;
+      std::vector<char> m_root_flips;
       int m_J;
    };
 
@@ -75,4 +207,14 @@ namespace magneto {
    /// </summary>
    std::vector<double> get_cached_exp_values(const int J, const double T);
 
+   /// <summary>SW bond freeze probability 1-exp(-2J/T)</summary>
+   double get_freeze_probability(const int J, const double T);
+
+   /// <summary>Row-major SW bond freeze probabilities 1-exp(-2J/T) for every site</summary>
+   std::vector<double> get_freeze_probability(const int Lx, const int Ly, const int J, const LatticeDType& temps);
+
+   /// <summary>Energy of the bonds of a row to its right and lower neighbours. The right neighbour
+   /// of the last site is wrapped explicitly, so this doesn't rely on the halo.</summary>
+   int get_row_energy(const char* row, const char* row_below, const int Lx);
+
 }
@@ -0,0 +1,159 @@
+#include "MultiSpinMetropolis.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+   constexpr uint64_t even_bits = 0x5555555555555555ull;
+   constexpr uint64_t odd_bits = 0xAAAAAAAAAAAAAAAAull;
+
+
+   /// <summary>Acceptance probability exp(-4|J|/T) as a 32 bit fixed point threshold</summary>
+   uint32_t get_acceptance_threshold(const int J, const double T) {
+      return magneto::CounterRng::get_threshold(exp(-4.0 * std::abs(J) / T));
+   }
+
+} // namespace {}
+
+
+magneto::MultiSpinMetropolis::MultiSpinMetropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng)
+   : m_Lx(Lx)
+   , m_Ly(Ly)
+   , m_words_per_row((Lx + 63) / 64)
+   , m_last_word_mask(Lx % 64 == 0 ? ~0ull : (1ull << (Lx % 64)) - 1)
+   , m_antialigned_toggle(J < 0 ? ~0ull : 0ull)
+   , m_threshold(get_acceptance_threshold(J, T))
+   , m_spins(static_cast<size_t>(m_words_per_row) * Ly, 0)
+   , m_rng(rng.get_seed())
+   , m_J(J)
+{ }
+
+
+bool magneto::MultiSpinMetropolis::set_temperature(const double T) {
+   m_threshold = get_acceptance_threshold(m_J, T);
+   return true;
+}
+
+
+void magneto::MultiSpinMetropolis::run(SpinLattice& lattice) {
+   if (m_resident_lattice != lattice.data())
+      pack(lattice);
+
+   update_color(0);
+   update_color(1);
+   m_lattice_is_current = false;
+}
+
+
+void magneto::MultiSpinMetropolis::write_back(SpinLattice& lattice) {
+   if (m_lattice_is_current || m_resident_lattice != lattice.data())
+      return;
+   unpack(lattice);
+   m_lattice_is_current = true;
+}
+
+
+void magneto::MultiSpinMetropolis::reset_totals() {
+   LatticeAlgorithm::reset_totals();
+   m_resident_lattice = nullptr;
+   m_lattice_is_current = true;
+}
+
+
+void magneto::MultiSpinMetropolis::pack(const SpinLattice& lattice) {
+   std::fill(m_spins.begin(), m_spins.end(), 0ull);
+   for (int i = 0; i < m_Ly; ++i) {
+      uint64_t* row = &m_spins[static_cast<size_t>(i) * m_words_per_row];
+      const char* lattice_row = lattice.data() + lattice.get_index(i, 0);
+      for (int j = 0; j < m_Lx; ++j) {
+         if (lattice_row[j] > 0)
+            row[j / 64] |= 1ull << (j % 64);
+      }
+   }
+   m_resident_lattice = lattice.data();
+   m_lattice_is_current = true;
+}
+
+
+void magneto::MultiSpinMetropolis::unpack(SpinLattice& lattice) const {
+   for (int i = 0; i < m_Ly; ++i) {
+      const uint64_t* row = &m_spins[static_cast<size_t>(i) * m_words_per_row];
+      char* lattice_row = lattice.data() + lattice.get_index(i, 0);
+      for (int k = 0; k < m_words_per_row; ++k) {
+         const int bits = k == m_words_per_row - 1 ? m_Lx - 64 * k : 64;
+         for (int b = 0; b < bits; ++b)
+            lattice_row[64 * k + b] = static_cast<char>(((row[k] >> b) & 1) * 2 - 1);
+      }
+   }
+   lattice.update_halo();
+}
+
+
+/// <summary>Returns a word whose bits in needed_lanes are one with probability threshold/2^32.
+/// <para>Compares 32 bit random numbers, one per lane, with the threshold one bit plane at a time,
+/// starting with the most significant one. Lanes drop out as soon as they are decided, so usually
+/// only a handful of random words are needed.</para></summary>
+uint64_t magneto::MultiSpinMetropolis::get_bernoulli_word(uint64_t needed_lanes) {
+   uint64_t less = 0;
+   for (int bit = 31; bit >= 0 && needed_lanes != 0; --bit) {
+      const uint64_t random_bits = m_rng();
+      if ((m_threshold >> bit) & 1u) {
+         less |= needed_lanes & ~random_bits;
+         needed_lanes &= random_bits;
+      }
+      else
+         needed_lanes &= ~random_bits;
+   }
+   return less;
+}
+
+
+void magneto::MultiSpinMetropolis::update_color(const int color) {
+   const int W = m_words_per_row;
+   const int last_bit = (m_Lx - 1) % 64;
+   for (int i = 0; i < m_Ly; ++i) {
+      uint64_t* row = &m_spins[static_cast<size_t>(i) * W];
+      const uint64_t* row_up = &m_spins[static_cast<size_t>(i == 0 ? m_Ly - 1 : i - 1) * W];
+      const uint64_t* row_down = &m_spins[static_cast<size_t>(i + 1 == m_Ly ? 0 : i + 1) * W];
+
+      // Bit b of a word is site j=64k+b, so the color of a bit only depends on the row and b
+      const uint64_t color_mask = ((i + color) % 2 == 0) ? even_bits : odd_bits;
+
+      for (int k = 0; k < W; ++k) {
+         const uint64_t s = row[k];
+
+         // Words holding the left (j-1) and right (j+1) neighbour of every bit, wrapping periodically
+         uint64_t left = s << 1;
+         left |= k > 0 ? row[k - 1] >> 63 : (row[W - 1] >> last_bit) & 1ull;
+         uint64_t right = s >> 1;
+         if (k + 1 < W)
+            right |= row[k + 1] << 63;
+         if (k + 1 == W)
+            right = (right & (m_last_word_mask >> 1)) | ((row[0] & 1ull) << last_bit);
+
+         // Anti-aligned neighbours (aligned ones for antiferromagnetic J)
+         const uint64_t a1 = s ^ left ^ m_antialigned_toggle;
+         const uint64_t a2 = s ^ right ^ m_antialigned_toggle;
+         const uint64_t a3 = s ^ row_up[k] ^ m_antialigned_toggle;
+         const uint64_t a4 = s ^ row_down[k] ^ m_antialigned_toggle;
+
+         // dE = 8|J| - 4|J|*count. So count>=2 always flips, count=1 and count=0 need random numbers
+         const uint64_t count_zero = ~(a1 | a2 | a3 | a4);
+         const uint64_t count_two_plus = (a1 & a2) | (a1 & a3) | (a1 & a4) | (a2 & a3) | (a2 & a4) | (a3 & a4);
+         const uint64_t count_one = ~(count_zero | count_two_plus);
+
+         const uint64_t update_mask = k + 1 == W ? color_mask & m_last_word_mask : color_mask;
+         const uint64_t accept_once = get_bernoulli_word((count_zero | count_one) & update_mask);
+         const uint64_t accept_twice = accept_once & get_bernoulli_word(count_zero & accept_once & update_mask);
+         const uint64_t flips = (count_two_plus | (count_one & accept_once) | (count_zero & accept_twice)) & update_mask;
+         row[k] = s ^ flips;
+      }
+   }
+}
+
+
+bool magneto::is_checkerboard_compatible(const int Lx, const int Ly) {
+   return Lx % 2 == 0 && Ly % 2 == 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "LatticeAlgorithms.h"
+
+#include <cstdint>
+#include <random>
+
+
+namespace magneto {
+
+   /// <summary>Checkerboard Metropolis with multi-spin coding: 64 spins per uint64_t
+   /// <para>Spins are stored row-wise as bits (1 = up). A sweep updates all sites of one checkerboard
+   /// color, then all of the other one. For every word, the number of anti-aligned neighbours is
+   /// computed with bitwise logic and the acceptance is decided with random bit masks that are one
+   /// with probability exp(-4|J|/T). The exp(-8|J|/T) case uses the AND of two such masks.</para>
+   /// <para>The packed lattice stays resident between run() calls, the SpinLattice is only written
+   /// back by write_back(), i.e. for measurements and snapshots. It is packed again when a different
+   /// lattice is passed in. A lattice that was overwritten in place keeps its address, so that isn't
+   /// noticed without reset_totals(). Requires even Lx and Ly for the checkerboard decomposition to
+   /// be valid.</para>
+   /// <para>The word kernel doesn't know the energy change of its flips, so totals aren't tracked and
+   /// every measurement scans the written back lattice.</para>
+   /// </summary>
+   class CLASS_DECLSPEC MultiSpinMetropolis : public LatticeAlgorithm {
+   public:
+      MultiSpinMetropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng);
+      virtual void run(SpinLattice& lattice);
+      virtual void write_back(SpinLattice& lattice);
+      virtual void reset_totals();
+      virtual bool set_temperature(const double T);
+
+   private:
+      void pack(const SpinLattice& lattice);
+      void unpack(SpinLattice& lattice) const;
+      void update_color(const int color);
+      [[nodiscard]] uint64_t get_bernoulli_word(uint64_t needed_lanes);
+
+      int m_Lx;
+      int m_Ly;
+      int m_words_per_row;
+      uint64_t m_last_word_mask;
+      uint64_t m_antialigned_toggle;
+      uint32_t m_threshold;
+      std::vector<uint64_t> m_spins;
+      const char* m_resident_lattice = nullptr;
+      bool m_lattice_is_current = true;
+      std::mt19937_64 m_rng;
+      int m_J;
+   };
+
+   /// <summary>Returns true if the lattice dimensions allow the checkerboard decomposition</summary>
+   bool is_checkerboard_compatible(const int Lx, const int Ly);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "types.h"
+
+#include <new>
+#include <vector>
+
+
+namespace magneto {
+
+   /// <summary>Allocator handing out memory aligned to (at least) a cache line</summary>
+   template<class T, std::size_t Alignment = 64>
+   struct AlignedAllocator {
+      using value_type = T;
+      template<class U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+      AlignedAllocator() = default;
+      template<class U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+      [[nodiscard]] T* allocate(const std::size_t n);
+      void deallocate(T* p, const std::size_t n);
+   };
+
+   template<class T, class U, std::size_t Alignment>
+   bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+   template<class T, class U, std::size_t Alignment>
+   bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
+
+
+   /// <summary>2D lattice in one contiguous allocation with cache-line aligned rows and a one-cell
+   /// halo ring around it.
+   /// <para>The halo mirrors the opposite edges (periodic boundary conditions), so the four
+   /// neighbours of a site at flat index k are always at k-1, k+1, k-stride and k+stride. No modulo
+   /// is needed in the kernels. All (i, j) coordinates in the interface are unpadded,
+   /// i.e. 0 &lt;= i &lt; Ly and 0 &lt;= j &lt; Lx.</para>
+   /// <para>Writes through set() keep the halo consistent. Writes through the raw index operator
+   /// don't, call update_halo() after those.</para>
+   /// </summary>
+   template<class T>
+   class PaddedLattice {
+   public:
+      PaddedLattice() = default;
+      PaddedLattice(const int Lx, const int Ly, const T& value = T());
+      explicit PaddedLattice(const LatticeTType<T>& lattice);
+
+      [[nodiscard]] int get_Lx() const;
+      [[nodiscard]] int get_Ly() const;
+
+      /// <summary>Distance in elements between two rows</summary>
+      [[nodiscard]] int get_stride() const;
+
+      /// <summary>Flat index of the site (i, j)</summary>
+      [[nodiscard]] int get_index(const int i, const int j) const;
+
+      [[nodiscard]] const T& operator()(const int i, const int j) const;
+      [[nodiscard]] const T& operator[](const int index) const;
+      [[nodiscard]] T& operator[](const int index);
+      [[nodiscard]] const T* data() const;
+      [[nodiscard]] T* data();
+
+      /// <summary>Sets one site and its halo copies if it's on the edge</summary>
+      void set(const int i, const int j, const T& value);
+
+      /// <summary>Rewrites the complete halo ring from the interior</summary>
+      void update_halo();
+
+      /// <summary>Returns the interior as nested vectors</summary>
+      [[nodiscard]] LatticeTType<T> get_nested() const;
+
+   private:
+      /// <summary>Row length rounded up so that every row starts on a cache line</summary>
+      [[nodiscard]] static int get_aligned_stride(const int Lx);
+
+      int m_Lx = 0;
+      int m_Ly = 0;
+      int m_stride = 0;
+      std::vector<T, AlignedAllocator<T>> m_data;
+   };
+
+   using SpinLattice = PaddedLattice<char>;
+
+
+   template<class T>
+   std::pair<unsigned int, unsigned int> get_dimensions_of_lattice(const PaddedLattice<T>& lattice) {
+      return { static_cast<unsigned int>(lattice.get_Lx()), static_cast<unsigned int>(lattice.get_Ly()) };
+   }
+}
+
+#include "PaddedLattice.hpp"
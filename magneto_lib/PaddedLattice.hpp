@@ -0,0 +1,142 @@
+#pragma once
+
+#include "PaddedLattice.h"
+
+#include <algorithm>
+
+
+template<class T, std::size_t Alignment>
+T* magneto::AlignedAllocator<T, Alignment>::allocate(const std::size_t n) {
+   return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+}
+
+
+template<class T, std::size_t Alignment>
+void magneto::AlignedAllocator<T, Alignment>::deallocate(T* p, const std::size_t /*n*/) {
+   ::operator delete(p, std::align_val_t(Alignment));
+}
+
+
+template<class T>
+int magneto::PaddedLattice<T>::get_aligned_stride(const int Lx) {
+   constexpr int cache_line_elements = static_cast<int>(64 / sizeof(T)) > 0 ? static_cast<int>(64 / sizeof(T)) : 1;
+   const int padded_length = Lx + 2;
+   return (padded_length + cache_line_elements - 1) / cache_line_elements * cache_line_elements;
+}
+
+
+template<class T>
+magneto::PaddedLattice<T>::PaddedLattice(const int Lx, const int Ly, const T& value)
+   : m_Lx(Lx)
+   , m_Ly(Ly)
+   , m_stride(get_aligned_stride(Lx))
+   , m_data(static_cast<size_t>(m_stride) * (Ly + 2), value)
+{ }
+
+
+template<class T>
+magneto::PaddedLattice<T>::PaddedLattice(const LatticeTType<T>& lattice)
+   : PaddedLattice(static_cast<int>(lattice[0].size()), static_cast<int>(lattice.size()))
+{
+   for (int i = 0; i < m_Ly; ++i) {
+      for (int j = 0; j < m_Lx; ++j)
+         m_data[get_index(i, j)] = lattice[i][j];
+   }
+   update_halo();
+}
+
+
+template<class T>
+int magneto::PaddedLattice<T>::get_Lx() const {
+   return m_Lx;
+}
+
+
+template<class T>
+int magneto::PaddedLattice<T>::get_Ly() const {
+   return m_Ly;
+}
+
+
+template<class T>
+int magneto::PaddedLattice<T>::get_stride() const {
+   return m_stride;
+}
+
+
+template<class T>
+int magneto::PaddedLattice<T>::get_index(const int i, const int j) const {
+   return (i + 1) * m_stride + j + 1;
+}
+
+
+template<class T>
+const T& magneto::PaddedLattice<T>::operator()(const int i, const int j) const {
+   return m_data[get_index(i, j)];
+}
+
+
+template<class T>
+const T& magneto::PaddedLattice<T>::operator[](const int index) const {
+   return m_data[index];
+}
+
+
+template<class T>
+T& magneto::PaddedLattice<T>::operator[](const int index) {
+   return m_data[index];
+}
+
+
+template<class T>
+const T* magneto::PaddedLattice<T>::data() const {
+   return m_data.data();
+}
+
+
+template<class T>
+T* magneto::PaddedLattice<T>::data() {
+   return m_data.data();
+}
+
+
+template<class T>
+void magneto::PaddedLattice<T>::set(const int i, const int j, const T& value) {
+   const int index = get_index(i, j);
+   m_data[index] = value;
+
+   // Edge sites also live in the halo on the opposite side. No else-branches so that Lx=1 or Ly=1
+   // still work.
+   if (j == 0)
+      m_data[index + m_Lx] = value;
+   if (j == m_Lx - 1)
+      m_data[index - m_Lx] = value;
+   if (i == 0)
+      m_data[index + m_Ly * m_stride] = value;
+   if (i == m_Ly - 1)
+      m_data[index - m_Ly * m_stride] = value;
+}
+
+
+template<class T>
+void magneto::PaddedLattice<T>::update_halo() {
+   // Left and right columns first, so that the row copies below also fill the corners
+   for (int i = 1; i <= m_Ly; ++i) {
+      T* row = &m_data[static_cast<size_t>(i) * m_stride];
+      row[0] = row[m_Lx];
+      row[m_Lx + 1] = row[1];
+   }
+   std::copy_n(&m_data[static_cast<size_t>(m_Ly) * m_stride], m_stride, &m_data[0]);
+   std::copy_n(&m_data[m_stride], m_stride, &m_data[static_cast<size_t>(m_Ly + 1) * m_stride]);
+}
+
+
+template<class T>
+magneto::LatticeTType<T> magneto::PaddedLattice<T>::get_nested() const {
+   LatticeTType<T> lattice(m_Ly, std::vector<T>(m_Lx));
+   for (int i = 0; i < m_Ly; ++i) {
+      const T* row = &m_data[get_index(i, 0)];
+      std::copy_n(row, m_Lx, lattice[i].begin());
+   }
+   return lattice;
+}
@@ -0,0 +1,205 @@
+#include "ParallelSW.h"
+#include "CheckerboardMetropolis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+
+namespace {
+
+   int find_root(std::atomic<int>* parent, int site) {
+      // Path halving. Only non-roots are rewritten and only to one of their ancestors, so concurrent
+      // halving and linking never disconnect a site from its cluster.
+      while (true) {
+         const int next = parent[site].load(std::memory_order_relaxed);
+         if (next == site)
+            return site;
+         const int grandparent = parent[next].load(std::memory_order_relaxed);
+         if (grandparent != next)
+            parent[site].store(grandparent, std::memory_order_relaxed);
+         site = grandparent;
+      }
+   }
+
+
+   /// <summary>Links the clusters of a and b, can be called concurrently
+   /// <para>The larger root is hooked under the smaller one with a CAS that only succeeds if it is
+   /// still a root. If another thread linked it in the meantime, the roots are searched again.</para>
+   /// </summary>
+   void unite_concurrent(std::atomic<int>* parent, int a, int b) {
+      while (true) {
+         a = find_root(parent, a);
+         b = find_root(parent, b);
+         if (a == b)
+            return;
+         if (a < b)
+            std::swap(a, b);
+         int expected = a;
+         if (parent[a].compare_exchange_weak(expected, b, std::memory_order_acq_rel))
+            return;
+      }
+   }
+
+
+   /// <summary>First and one past the last row of a strip</summary>
+   std::pair<int, int> get_strip_rows(const int strip, const int strips, const int Ly) {
+      return { strip * Ly / strips, (strip + 1) * Ly / strips };
+   }
+
+
+   template<class TFreezeProbability>
+   magneto::LatticeTotals parallel_swendsen_wang_step(
+      magneto::SpinLattice& lattice,
+      std::atomic<int>* parent,
+      std::vector<char>& root_flips,
+      const magneto::CounterRng& rng,
+      const uint32_t sweep,
+      const int threads,
+      const TFreezeProbability& freeze_probability
+   ) {
+      const int Lx = lattice.get_Lx();
+      const int Ly = lattice.get_Ly();
+      const int stride = lattice.get_stride();
+      const int strips = std::min(threads, Ly);
+      int energy = 0;
+      int magnetization = 0;
+
+#pragma omp parallel num_threads(strips) reduction(+:energy, magnetization)
+      {
+         // The team can be smaller than requested, then a thread handles several strips
+         const int team_size = omp_get_num_threads();
+
+         // Local labelling. Only the strip's own sites are touched, so these unions can't race.
+         for (int strip = omp_get_thread_num(); strip < strips; strip += team_size) {
+            const auto [first_row, end_row] = get_strip_rows(strip, strips, Ly);
+            for (int site = first_row * Lx; site < end_row * Lx; ++site)
+               parent[site].store(site, std::memory_order_relaxed);
+            for (int i = first_row; i < end_row; ++i) {
+               const char* row = lattice.data() + lattice.get_index(i, 0);
+               const bool last_row_of_strip = i + 1 == end_row;
+               for (int j = 0; j < Lx; ++j) {
+                  const int site = i * Lx + j;
+                  // Randoms are only drawn if a bond can form at all
+                  const bool right_aligned = row[j] == row[j + 1];
+                  const bool down_aligned = !last_row_of_strip && row[j] == row[j + stride];
+                  if (!right_aligned && !down_aligned)
+                     continue;
+                  const double p = freeze_probability(site);
+                  const std::array<uint32_t, 4> words = rng.get_words(sweep, site);
+                  if (right_aligned && magneto::CounterRng::get_uniform(words[0], words[1]) < p)
+                     unite_concurrent(parent, site, j + 1 == Lx ? site - j : site + 1);
+                  if (down_aligned && magneto::CounterRng::get_uniform(words[2], words[3]) < p)
+                     unite_concurrent(parent, site, site + Lx);
+               }
+            }
+         }
+#pragma omp barrier
+
+         // Bonds from the last row of every strip into the first row of the next one
+         for (int strip = omp_get_thread_num(); strip < strips; strip += team_size) {
+            const int i = get_strip_rows(strip, strips, Ly).second - 1;
+            const char* row = lattice.data() + lattice.get_index(i, 0);
+            for (int j = 0; j < Lx; ++j) {
+               const int site = i * Lx + j;
+               if (row[j] != row[j + stride])
+                  continue;
+               const std::array<uint32_t, 4> words = rng.get_words(sweep, site);
+               if (magneto::CounterRng::get_uniform(words[2], words[3]) < freeze_probability(site))
+                  unite_concurrent(parent, site, i + 1 == Ly ? j : site + Lx);
+            }
+         }
+#pragma omp barrier
+
+         // Every root draws the flip of its cluster
+         for (int strip = omp_get_thread_num(); strip < strips; strip += team_size) {
+            const auto [first_row, end_row] = get_strip_rows(strip, strips, Ly);
+            for (int site = first_row * Lx; site < end_row * Lx; ++site) {
+               if (parent[site].load(std::memory_order_relaxed) == site)
+                  root_flips[site] = rng.get_words(sweep, site, 1)[0] >> 31;
+            }
+         }
+#pragma omp barrier
+
+         for (int strip = omp_get_thread_num(); strip < strips; strip += team_size) {
+            const auto [first_row, end_row] = get_strip_rows(strip, strips, Ly);
+            for (int i = first_row; i < end_row; ++i) {
+               char* row = lattice.data() + lattice.get_index(i, 0);
+               for (int j = 0; j < Lx; ++j) {
+                  if (root_flips[find_root(parent, i * Lx + j)])
+                     row[j] = -row[j];
+                  magnetization += row[j];
+               }
+               if (i > first_row)
+                  energy += magneto::get_row_energy(row - stride, row, Lx);
+            }
+         }
+#pragma omp barrier
+
+         // The bonds between two strips are counted once both are flipped
+         for (int strip = omp_get_thread_num(); strip < strips; strip += team_size) {
+            const int first_row = get_strip_rows(strip, strips, Ly).first;
+            const int row_above = first_row == 0 ? Ly - 1 : first_row - 1;
+            energy += magneto::get_row_energy(lattice.data() + lattice.get_index(row_above, 0), lattice.data() + lattice.get_index(first_row, 0), Lx);
+         }
+      }
+      lattice.update_halo();
+      return { energy, magnetization };
+   }
+
+} // namespace {}
+
+
+magneto::ParallelSW::ParallelSW(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const int threads /*= 0*/)
+   : m_parent(new std::atomic<int>[Lx * Ly])
+   , m_root_flips(Lx * Ly)
+   , m_rng(rng)
+   , m_freeze_probability(get_freeze_probability(J, T))
+   , m_J(J)
+   , m_threads(get_thread_count(threads))
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::ParallelSW::set_temperature(const double T) {
+   m_freeze_probability = get_freeze_probability(m_J, T);
+   return true;
+}
+
+
+void magneto::ParallelSW::run(SpinLattice& lattice) {
+   set_totals(parallel_swendsen_wang_step(
+      lattice, m_parent.get(), m_root_flips, m_rng, m_sweep++, m_threads,
+      [&](const int /*site*/) {return m_freeze_probability; }
+   ));
+}
+
+
+magneto::VariableParallelSW::VariableParallelSW(
+   const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng, const int threads /*= 0*/
+)
+   : m_parent(new std::atomic<int>[Lx * Ly])
+   , m_root_flips(Lx * Ly)
+   , m_rng(rng)
+   , m_freeze_probability(get_freeze_probability(Lx, Ly, J, T))
+   , m_J(J)
+   , m_threads(get_thread_count(threads))
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::VariableParallelSW::set_temperature_field(const LatticeDType& T) {
+   const auto [Lx, Ly] = get_dimensions_of_lattice(T);
+   m_freeze_probability = get_freeze_probability(Lx, Ly, m_J, T);
+   return true;
+}
+
+
+void magneto::VariableParallelSW::run(SpinLattice& lattice) {
+   set_totals(parallel_swendsen_wang_step(
+      lattice, m_parent.get(), m_root_flips, m_rng, m_sweep++, m_threads,
+      [&](const int site) {return m_freeze_probability[site]; }
+   ));
+}
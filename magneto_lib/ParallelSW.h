@@ -0,0 +1,54 @@
+#pragma once
+
+#include "LatticeAlgorithms.h"
+
+#include <atomic>
+#include <memory>
+
+
+namespace magneto {
+
+   /// <summary>Swendsen-Wang step with the cluster labelling split across threads
+   /// <para>The lattice is cut into horizontal strips, one per thread. Every thread first labels the
+   /// bonds inside its strip with a plain union-find. The bonds between neighbouring strips (and the
+   /// periodic wrap) are then merged concurrently with a lock-free union-find that links roots with a
+   /// compare-and-swap on the parent pointer. A last pass draws one flip random per cluster root and
+   /// flips the sites. Bonds and flips have the same distribution as in SW.</para>
+   /// <para>Roots are always the smallest site of their cluster and all randoms are counter-based
+   /// per site, so the result doesn't depend on the thread count.</para>
+   /// <para>The flip pass also sums energy and magnetization, so measurements don't scan the
+   /// lattice.</para>
+   /// </summary>
+   class CLASS_DECLSPEC ParallelSW : public LatticeAlgorithm {
+   public:
+      ParallelSW(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const int threads = 0);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
+
+   private:
+      std::unique_ptr<std::atomic<int>[]> m_parent;
+      std::vector<char> m_root_flips;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
+      double m_freeze_probability;
+      int m_J;
+      int m_threads;
+   };
+
+
+   class VariableParallelSW : public LatticeAlgorithm {
+   public:
+      VariableParallelSW(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng, const int threads = 0);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature_field(const LatticeDType& T);
+
+   private:
+      std::unique_ptr<std::atomic<int>[]> m_parent;
+      std::vector<char> m_root_flips;
+      CounterRng m_rng;
+      uint32_t m_sweep = 0;
+      std::vector<double> m_freeze_probability;
+      int m_J;
+      int m_threads;
+   };
+}
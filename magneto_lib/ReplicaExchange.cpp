@@ -0,0 +1,56 @@
+#include "ReplicaExchange.h"
+#include "IsingSystem.h"
+#include "logging.h"
+
+#include <cmath>
+
+
+magneto::ReplicaExchange::ReplicaExchange(const std::vector<double>& temps, const int J, const CounterRng& rng)
+   : m_temps(temps)
+   , m_J(J)
+   , m_attempts(temps.size() > 1 ? temps.size() - 1 : 0, 0)
+   , m_accepted(temps.size() > 1 ? temps.size() - 1 : 0, 0)
+   , m_rng(rng)
+{ }
+
+
+void magneto::ReplicaExchange::attempt_swaps(const std::vector<SpinLattice*>& lattices) {
+   for (size_t pair = m_first_pair; pair + 1 < lattices.size(); pair += 2) {
+      SpinLattice& a = *lattices[pair];
+      SpinLattice& b = *lattices[pair + 1];
+
+      // get_E is per site and in units of J
+      const double site_count = static_cast<double>(a.get_Lx()) * a.get_Ly();
+      const double H_a = m_J * get_E(a) * site_count;
+      const double H_b = m_J * get_E(b) * site_count;
+      const double exponent = (1.0 / m_temps[pair] - 1.0 / m_temps[pair + 1]) * (H_a - H_b);
+
+      ++m_attempts[pair];
+      const std::array<uint32_t, 4> words = m_rng.get_words(m_round, static_cast<uint32_t>(pair));
+      if (exponent >= 0.0 || CounterRng::get_uniform(words[0], words[1]) < exp(exponent)) {
+         std::swap(a, b);
+         ++m_accepted[pair];
+      }
+   }
+   m_first_pair = 1 - m_first_pair;
+   ++m_round;
+}
+
+
+std::vector<double> magneto::ReplicaExchange::get_acceptance_rates() const {
+   std::vector<double> rates;
+   for (size_t pair = 0; pair < m_attempts.size(); ++pair)
+      rates.emplace_back(m_attempts[pair] == 0 ? 0.0 : static_cast<double>(m_accepted[pair]) / m_attempts[pair]);
+   return rates;
+}
+
+
+void magneto::ReplicaExchange::log_acceptance_rates() const {
+   const std::vector<double> rates = get_acceptance_rates();
+   for (size_t pair = 0; pair < rates.size(); ++pair) {
+      get_logger()->info(
+         "Replica exchange T={:.3f} <-> T={:.3f}: {:.1f}% of {} swaps accepted",
+         m_temps[pair], m_temps[pair + 1], 100.0 * rates[pair], m_attempts[pair]
+      );
+   }
+}
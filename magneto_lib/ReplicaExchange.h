@@ -0,0 +1,35 @@
+#pragma once
+
+#include "PaddedLattice.h"
+#include "CounterRng.h"
+
+
+namespace magneto {
+
+   /// <summary>Configuration swaps between systems at neighbouring temperatures (parallel tempering)
+   /// <para>A swap of the configurations at T_a and T_b is accepted with the Metropolis probability
+   /// min(1, exp((1/T_a - 1/T_b) * (H_a - H_b))). Every call attempts the swaps of either all even or
+   /// all odd neighbour pairs, alternating between calls, so that no lattice takes part in two
+   /// swaps at once.</para>
+   /// </summary>
+   class ReplicaExchange {
+   public:
+      /// <summary>temps must be ordered, the lattices passed to attempt_swaps are in the same order</summary>
+      ReplicaExchange(const std::vector<double>& temps, const int J, const CounterRng& rng);
+
+      void attempt_swaps(const std::vector<SpinLattice*>& lattices);
+
+      /// <summary>Accepted fraction of the swaps between temps[i] and temps[i+1]</summary>
+      [[nodiscard]] std::vector<double> get_acceptance_rates() const;
+      void log_acceptance_rates() const;
+
+   private:
+      std::vector<double> m_temps;
+      int m_J;
+      std::vector<unsigned int> m_attempts;
+      std::vector<unsigned int> m_accepted;
+      int m_first_pair = 0;
+      uint32_t m_round = 0;
+      CounterRng m_rng;
+   };
+}
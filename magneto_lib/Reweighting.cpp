@@ -0,0 +1,159 @@
+#include "Reweighting.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+   constexpr double wham_tolerance = 1e-8;
+   constexpr int wham_max_iterations = 10000;
+
+
+   double get_log_sum_exp(const std::vector<double>& values) {
+      const double maximum = *std::max_element(values.cbegin(), values.cend());
+      double sum = 0.0;
+      for (const double value : values)
+         sum += exp(value - maximum);
+      return maximum + log(sum);
+   }
+
+
+   /// <summary>Total energy H = J*N*e of a measurement</summary>
+   double get_total_energy(const magneto::PhysicalMeasurement& measurement, const int J, const int N) {
+      return J * N * measurement.energy;
+   }
+
+
+   /// <summary>Same observables as get_physical_results, but from weighted samples</summary>
+   magneto::PhysicsResult get_weighted_result(
+      const std::vector<const magneto::PhysicalMeasurement*>& samples,
+      const std::vector<double>& log_weights,
+      const double T,
+      const int N
+   ) {
+      const double maximum = *std::max_element(log_weights.cbegin(), log_weights.cend());
+      double weight_sum = 0.0, e_sum = 0.0, e2_sum = 0.0, m_sum = 0.0, m2_sum = 0.0, m4_sum = 0.0;
+      for (size_t n = 0; n < samples.size(); ++n) {
+         const double weight = exp(log_weights[n] - maximum);
+         const double e = samples[n]->energy;
+         const double m = samples[n]->magnetization;
+         weight_sum += weight;
+         e_sum += weight * e;
+         e2_sum += weight * e * e;
+         m_sum += weight * m;
+         m2_sum += weight * m * m;
+         m4_sum += weight * m * m * m * m;
+      }
+      const double mean_energy = e_sum / weight_sum;
+      const double mean_magnetization = m_sum / weight_sum;
+      const double cv = (e2_sum / weight_sum - mean_energy * mean_energy) * N / (T * T);
+      const double chi = (m2_sum / weight_sum - mean_magnetization * mean_magnetization) * N / T;
+      const double m2_mean = m2_sum / weight_sum;
+      magneto::PhysicsResult result{ T, mean_energy, cv, mean_magnetization, chi };
+      if (m2_mean > 0.0)
+         result.binder = 1.0 - m4_sum / weight_sum / (3.0 * m2_mean * m2_mean);
+      return result;
+   }
+
+} // namespace {}
+
+
+std::vector<magneto::PhysicsResult> magneto::get_single_histogram_results(
+   const std::vector<PhysicalProperties>& properties,
+   const int J,
+   const std::vector<double>& temps
+) {
+   std::vector<PhysicsResult> results;
+   if (properties.empty())
+      return results;
+   const int N = properties[0].Lx * properties[0].Ly;
+   for (const double T : temps) {
+      const auto closest = std::min_element(properties.cbegin(), properties.cend(),
+         [&](const PhysicalProperties& a, const PhysicalProperties& b) {
+            return std::abs(1.0 / a.T - 1.0 / T) < std::abs(1.0 / b.T - 1.0 / T);
+         }
+      );
+      std::vector<const PhysicalMeasurement*> samples;
+      std::vector<double> log_weights;
+      for (const PhysicalMeasurement& measurement : closest->measurements) {
+         samples.emplace_back(&measurement);
+         log_weights.emplace_back(-(1.0 / T - 1.0 / closest->T) * get_total_energy(measurement, J, N));
+      }
+      if (samples.empty())
+         continue;
+      results.emplace_back(get_weighted_result(samples, log_weights, T, N));
+   }
+   return results;
+}
+
+
+std::vector<magneto::PhysicsResult> magneto::get_multi_histogram_results(
+   const std::vector<PhysicalProperties>& properties,
+   const int J,
+   const std::vector<double>& temps
+) {
+   std::vector<PhysicsResult> results;
+   if (properties.empty())
+      return results;
+   const int N = properties[0].Lx * properties[0].Ly;
+   const size_t runs = properties.size();
+
+   std::vector<const PhysicalMeasurement*> samples;
+   std::vector<double> energies;
+   std::vector<double> log_sample_counts;
+   for (const PhysicalProperties& run : properties) {
+      for (const PhysicalMeasurement& measurement : run.measurements) {
+         samples.emplace_back(&measurement);
+         energies.emplace_back(get_total_energy(measurement, J, N));
+      }
+      log_sample_counts.emplace_back(run.measurements.empty() ? -std::numeric_limits<double>::infinity() : log(static_cast<double>(run.measurements.size())));
+   }
+   if (samples.empty())
+      return results;
+
+   // Dimensionless free energies f_k = -ln(Z_k), up to a common constant
+   std::vector<double> free_energies(runs, 0.0);
+   std::vector<double> log_denominators(samples.size());
+   std::vector<double> run_terms(runs);
+   std::vector<double> sample_terms(samples.size());
+   const auto update_denominators = [&]() {
+      for (size_t n = 0; n < samples.size(); ++n) {
+         for (size_t k = 0; k < runs; ++k)
+            run_terms[k] = log_sample_counts[k] + free_energies[k] - energies[n] / properties[k].T;
+         log_denominators[n] = get_log_sum_exp(run_terms);
+      }
+   };
+
+   int iteration = 0;
+   for (; iteration < wham_max_iterations; ++iteration) {
+      update_denominators();
+      double max_change = 0.0;
+      std::vector<double> new_free_energies(runs);
+      for (size_t k = 0; k < runs; ++k) {
+         for (size_t n = 0; n < samples.size(); ++n)
+            sample_terms[n] = -energies[n] / properties[k].T - log_denominators[n];
+         new_free_energies[k] = -get_log_sum_exp(sample_terms);
+      }
+      for (size_t k = 0; k < runs; ++k) {
+         new_free_energies[k] -= new_free_energies[0];
+         max_change = std::max(max_change, std::abs(new_free_energies[k] - free_energies[k]));
+      }
+      free_energies = new_free_energies;
+      if (max_change < wham_tolerance)
+         break;
+   }
+   if (iteration == wham_max_iterations)
+      get_logger()->warn("Multiple histogram free energies did not converge after {} iterations.", wham_max_iterations);
+   update_denominators();
+
+   std::vector<double> log_weights(samples.size());
+   for (const double T : temps) {
+      for (size_t n = 0; n < samples.size(); ++n)
+         log_weights[n] = -energies[n] / T - log_denominators[n];
+      results.emplace_back(get_weighted_result(samples, log_weights, T, N));
+   }
+   return results;
+}
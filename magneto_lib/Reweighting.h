@@ -0,0 +1,29 @@
+#pragma once
+
+#include "export_macro.h"
+#include "physics_tools.h"
+
+
+namespace magneto {
+
+   /// <summary>Single histogram reweighting: every temperature is derived from the samples of the
+   /// simulated temperature closest in 1/T, weighted with exp(-(1/T - 1/T_sim) * H)</summary>
+   CLASS_DECLSPEC std::vector<PhysicsResult> get_single_histogram_results(
+      const std::vector<PhysicalProperties>& properties,
+      const int J,
+      const std::vector<double>& temps
+   );
+
+
+   /// <summary>Multiple histogram reweighting (Ferrenberg-Swendsen / WHAM)
+   /// <para>The samples of all simulated temperatures are combined into one estimate of the density
+   /// of states. The free energies of the simulated temperatures are found by iterating the WHAM
+   /// equations, which gives every sample a weight for any temperature between the simulated ones.
+   /// </para>
+   /// </summary>
+   CLASS_DECLSPEC std::vector<PhysicsResult> get_multi_histogram_results(
+      const std::vector<PhysicalProperties>& properties,
+      const int J,
+      const std::vector<double>& temps
+   );
+}
@@ -0,0 +1,96 @@
+#include "RngPool.h"
+
+#include <algorithm>
+
+
+namespace {
+   constexpr unsigned int max_rng_workers = 4;
+
+   unsigned int configured_workers = 0;
+   std::function<void(unsigned int)> configured_on_start;
+   std::atomic<bool> instantiated = false;
+}
+
+
+magneto::RngPool& magneto::RngPool::get() {
+   static RngPool pool(
+      configured_workers > 0 ? configured_workers : std::clamp(std::thread::hardware_concurrency(), 1u, max_rng_workers),
+      configured_on_start
+   );
+   return pool;
+}
+
+
+bool magneto::RngPool::is_instantiated() {
+   return instantiated;
+}
+
+
+void magneto::RngPool::configure(const unsigned int workers, std::function<void(unsigned int)> on_start) {
+   configured_workers = workers;
+   configured_on_start = std::move(on_start);
+}
+
+
+magneto::RngPool::RngPool(const unsigned int workers, const std::function<void(unsigned int)>& on_start) {
+   instantiated = true;
+   for (unsigned int i = 0; i < workers; ++i) {
+      m_workers.emplace_back([this, i, on_start] {
+         if (on_start)
+            on_start(i);
+         work();
+      });
+   }
+}
+
+
+magneto::RngPool::~RngPool() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+   }
+   m_condition.notify_all();
+   for (std::thread& worker : m_workers)
+      worker.join();
+}
+
+
+void magneto::RngPool::submit(std::function<void()> task) {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.emplace_back(std::move(task));
+   }
+   m_condition.notify_one();
+}
+
+
+void magneto::RngPool::work() {
+   while (true) {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_condition.wait(lock, [this] {return m_stop || !m_tasks.empty(); });
+         if (m_tasks.empty())
+            return;
+         task = std::move(m_tasks.front());
+         m_tasks.pop_front();
+      }
+      task();
+   }
+}
+
+
+void magneto::RngPool::add_starvation(const long long nanoseconds) {
+   ++m_starved_refills;
+   m_starved_ns += nanoseconds;
+}
+
+
+unsigned long long magneto::RngPool::get_starved_refills() const {
+   return m_starved_refills;
+}
+
+
+long long magneto::RngPool::get_starved_ns() const {
+   return m_starved_ns;
+}
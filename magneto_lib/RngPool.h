@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace magneto {
+
+   /// <summary>Process-wide pool of threads that fill random number buffers
+   /// <para>The number of workers is capped, no matter how many algorithm instances (one per
+   /// temperature) submit work. It also collects how long consumers had to wait for their buffers.
+   /// </para>
+   /// </summary>
+   class RngPool {
+   public:
+      static RngPool& get();
+      ~RngPool();
+
+      /// <summary>Whether get() was called yet, without starting the workers</summary>
+      [[nodiscard]] static bool is_instantiated();
+
+      /// <summary>Worker count and a function every worker calls first, e.g. to pin itself. Only
+      /// has an effect before the first get().</summary>
+      static void configure(const unsigned int workers, std::function<void(unsigned int)> on_start);
+
+      void submit(std::function<void()> task);
+
+      /// <summary>Records one BufferStructure::refill() that blocked for the given time</summary>
+      void add_starvation(const long long nanoseconds);
+      [[nodiscard]] unsigned long long get_starved_refills() const;
+      [[nodiscard]] long long get_starved_ns() const;
+
+   private:
+      RngPool(const unsigned int workers, const std::function<void(unsigned int)>& on_start);
+      void work();
+
+      std::vector<std::thread> m_workers;
+      std::deque<std::function<void()>> m_tasks;
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+      bool m_stop = false;
+
+      std::atomic<unsigned long long> m_starved_refills = 0;
+      std::atomic<long long> m_starved_ns = 0;
+   };
+}
@@ -0,0 +1,88 @@
+#include "SimdMetropolis.h"
+#include "logging.h"
+
+#include <chrono>
+#include <cmath>
+
+
+namespace {
+
+   uint64_t get_splitmix64(uint64_t& state) {
+      uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+   }
+
+
+   void (*get_sweep_function(const magneto::SimdLevel level))(magneto::SimdSweepData&, const int) {
+      if (level == magneto::SimdLevel::AVX512)
+         return magneto::simd_sweep_color_avx512;
+      else if (level == magneto::SimdLevel::AVX2)
+         return magneto::simd_sweep_color_avx2;
+      else
+         return magneto::simd_sweep_color_sse2;
+   }
+
+} // namespace {}
+
+
+magneto::SimdMetropolis::SimdMetropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const SimdLevel level)
+   : m_simd_level(level)
+   , m_sweep_color(get_sweep_function(level))
+   , m_J(J)
+{
+   m_data.Lx = Lx;
+   m_data.Ly = Ly;
+   m_data.antiferromagnetic = J < 0;
+   set_thresholds(T);
+
+   uint64_t seed = rng.get_seed();
+   for (int lane = 0; lane < 8; ++lane) {
+      m_data.rng_s0[lane] = get_splitmix64(seed);
+      m_data.rng_s1[lane] = get_splitmix64(seed);
+   }
+   m_data.scalar_rng = get_splitmix64(seed) | 1ull;
+}
+
+
+magneto::SimdMetropolis::~SimdMetropolis() {
+   if (m_elapsed_ns == 0)
+      return;
+   get_logger()->info(
+      "SIMD Metropolis ({} kernel): {:.3f} site updates per ns over {} site updates",
+      get_simd_level_name(m_simd_level), m_site_updates * 1.0 / m_elapsed_ns, m_site_updates
+   );
+}
+
+
+bool magneto::SimdMetropolis::set_temperature(const double T) {
+   set_thresholds(T);
+   return true;
+}
+
+
+void magneto::SimdMetropolis::set_thresholds(const double T) {
+   // Only the two uphill moves need thresholds: dE = 4|J| and dE = 8|J|
+   for (const int prod : {2, 4}) {
+      const uint32_t threshold = CounterRng::get_threshold(exp(-2.0 * std::abs(m_J) * prod / T));
+      m_data.thresholds[prod + 4] = threshold;
+      m_data.threshold_bytes[prod + 4] = static_cast<uint8_t>(threshold >> 24);
+   }
+}
+
+
+void magneto::SimdMetropolis::run(SpinLattice& lattice) {
+   const auto start = std::chrono::steady_clock::now();
+
+   m_data.spins = lattice.data();
+   m_data.stride = lattice.get_stride();
+   m_sweep_color(m_data, 0);
+   lattice.update_halo();
+   m_sweep_color(m_data, 1);
+   lattice.update_halo();
+
+   const auto end = std::chrono::steady_clock::now();
+   m_elapsed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+   m_site_updates += static_cast<long long>(m_data.Lx) * m_data.Ly;
+}
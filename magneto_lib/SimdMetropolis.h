@@ -0,0 +1,35 @@
+#pragma once
+
+#include "LatticeAlgorithms.h"
+#include "SimdMetropolisKernel.h"
+#include "cpu_tools.h"
+
+
+namespace magneto {
+
+   /// <summary>Checkerboard Metropolis evaluating 16, 32 or 64 spins per instruction
+   /// <para>The kernel (SSE2, AVX2 or AVX-512) is chosen from the CPU at runtime. A lower level can be
+   /// forced, e.g. to compare the kernels. Neighbour sums, the threshold lookup and the comparison
+   /// with random numbers are all vectorized, see SimdMetropolisKernel.hpp. Throughput is written to the log when the instance is destroyed.
+   /// Requires even Lx and Ly.</para>
+   /// <para>The vector kernels only keep accept masks, so totals aren't tracked and every measurement
+   /// scans the lattice.</para>
+   /// </summary>
+   class CLASS_DECLSPEC SimdMetropolis : public LatticeAlgorithm {
+   public:
+      SimdMetropolis(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng, const SimdLevel level = get_simd_level());
+      virtual ~SimdMetropolis();
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
+
+   private:
+      void set_thresholds(const double T);
+
+      SimdSweepData m_data;
+      SimdLevel m_simd_level;
+      void (*m_sweep_color)(SimdSweepData& data, const int color);
+      int m_J;
+      long long m_site_updates = 0;
+      long long m_elapsed_ns = 0;
+   };
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace magneto {
+
+   /// <summary>Everything one checkerboard color pass of the SIMD kernels needs
+   /// <para>Deliberately plain data: the kernels live in translation units compiled for different
+   /// instruction sets and must not share any inline library code with the rest of the program.</para>
+   /// </summary>
+   struct SimdSweepData {
+      char* spins = nullptr; // data of a SpinLattice, including the halo
+      int Lx = 0;
+      int Ly = 0;
+      int stride = 0;
+      bool antiferromagnetic = false;
+
+      // Acceptance thresholds (probability * 2^32) indexed by sign(J)*s*(sum of neighbours) + 4
+      uint32_t thresholds[16] = {};
+      // Most significant byte of the thresholds, for the vectorized comparison
+      uint8_t threshold_bytes[16] = {};
+
+      // xorshift128+ state, one lane per 64 bit of vector width
+      uint64_t rng_s0[8] = {};
+      uint64_t rng_s1[8] = {};
+      // xorshift64* state for ties and the scalar tail of rows
+      uint64_t scalar_rng = 0;
+   };
+
+   void simd_sweep_color_sse2(SimdSweepData& data, const int color);
+   void simd_sweep_color_avx2(SimdSweepData& data, const int color);
+   void simd_sweep_color_avx512(SimdSweepData& data, const int color);
+}
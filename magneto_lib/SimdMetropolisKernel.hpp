@@ -0,0 +1,103 @@
+#pragma once
+
+// Shared kernel body of the SIMD Metropolis. Only included by the per-instruction-set translation
+// units, which define an Ops struct with the vector primitives. Everything in here has internal
+// linkage so the differently compiled copies can't be mixed up by the linker.
+
+#include "SimdMetropolisKernel.h"
+
+namespace {
+
+   uint32_t get_scalar_random(magneto::SimdSweepData& data) {
+      // xorshift64*
+      uint64_t x = data.scalar_rng;
+      x ^= x >> 12;
+      x ^= x << 25;
+      x ^= x >> 27;
+      data.scalar_rng = x;
+      return static_cast<uint32_t>((x * 2685821657736338717ull) >> 32);
+   }
+
+
+   /// <summary>Plain Metropolis step for the site p points to</summary>
+   void update_site_scalar(magneto::SimdSweepData& data, char* p) {
+      int prod = p[0] * (p[-1] + p[1] + p[-data.stride] + p[data.stride]);
+      if (data.antiferromagnetic)
+         prod = -prod;
+      if (prod <= 0 || get_scalar_random(data) < data.thresholds[prod + 4])
+         p[0] = -p[0];
+   }
+
+
+   /// <summary>Metropolis update of all sites with (i+j)%2 == color, Ops::width sites per iteration
+   /// <para>The uphill acceptance compares one random byte per lane with the most significant byte
+   /// of the threshold. Only lanes where those bytes are equal (1 in 256) need the remaining 24 bits,
+   /// which is done scalar. That keeps the full 32 bit precision of the acceptance probability.</para>
+   /// </summary>
+   template<class Ops>
+   void sweep_color(magneto::SimdSweepData& data, const int color) {
+      using V = typename Ops::V;
+      constexpr int width = Ops::width;
+      const int stride = data.stride;
+      const V zero = Ops::zero();
+      const V sign_bit = Ops::set1(static_cast<char>(0x80));
+      const V sign_flip = Ops::set1(static_cast<char>(data.antiferromagnetic ? -1 : 0));
+      const typename Ops::Table table = Ops::make_table(data.threshold_bytes);
+      V rng_s0 = Ops::load_state(data.rng_s0);
+      V rng_s1 = Ops::load_state(data.rng_s1);
+
+      for (int i = 0; i < data.Ly; ++i) {
+         char* row = data.spins + (i + 1) * stride + 1;
+
+         // Blocks start at even j, so the color of a lane only depends on the row and the lane
+         const V color_mask = Ops::color_mask((i + color) % 2);
+
+         int j = 0;
+         for (; j + width <= data.Lx; j += width) {
+            char* p = row + j;
+            const V center = Ops::load(p);
+            const V neighbour_sum = Ops::add(
+               Ops::add(Ops::load(p - 1), Ops::load(p + 1)),
+               Ops::add(Ops::load(p - stride), Ops::load(p + stride))
+            );
+
+            // prod = sign(J) * s * sum as conditional negation, dE = 2|J| * prod
+            const V negate = Ops::bit_xor(Ops::cmpgt(zero, center), sign_flip);
+            const V prod = Ops::sub(Ops::bit_xor(neighbour_sum, negate), negate);
+            const V uphill = Ops::cmpgt(prod, zero);
+
+            const V threshold = Ops::lookup(table, prod);
+            const V random = Ops::random(rng_s0, rng_s1);
+            const V below = Ops::cmpgt(Ops::bit_xor(threshold, sign_bit), Ops::bit_xor(random, sign_bit));
+            const V tie = Ops::bit_and(Ops::bit_and(Ops::cmpeq(random, threshold), uphill), color_mask);
+
+            // downhill or below threshold
+            const V accept = Ops::bit_or(Ops::bit_andnot(uphill, Ops::cmpeq(zero, zero)), below);
+            const V flip = Ops::bit_and(accept, color_mask);
+            const V flipped = Ops::sub(zero, center);
+            Ops::store(p, Ops::bit_or(Ops::bit_and(flip, flipped), Ops::bit_andnot(flip, center)));
+
+            uint64_t tie_lanes = Ops::movemask(tie);
+            while (tie_lanes != 0) {
+               int lane = 0;
+               while (((tie_lanes >> lane) & 1) == 0)
+                  ++lane;
+               tie_lanes &= tie_lanes - 1;
+               const int prod_lane = (p[lane] * (p[lane - 1] + p[lane + 1] + p[lane - stride] + p[lane + stride])) * (data.antiferromagnetic ? -1 : 1);
+               if ((get_scalar_random(data) >> 8) < (data.thresholds[prod_lane + 4] & 0xFFFFFFu))
+                  p[lane] = -p[lane];
+            }
+         }
+
+         // Scalar remainder of the row
+         for (; j < data.Lx; ++j) {
+            if ((i + j) % 2 == color)
+               update_site_scalar(data, row + j);
+         }
+      }
+
+      Ops::store_state(data.rng_s0, rng_s0);
+      Ops::store_state(data.rng_s1, rng_s1);
+   }
+
+} // namespace {}
@@ -0,0 +1,66 @@
+#include "SimdMetropolisKernel.h"
+
+#include <immintrin.h>
+
+
+namespace {
+
+   struct AVX2Ops {
+      using V = __m256i;
+      static constexpr int width = 32;
+
+      /// <summary>Thresholds broadcast into both 128 bit halves for the byte shuffle</summary>
+      struct Table {
+         V thresholds;
+         V offset;
+      };
+
+      static V load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const V*>(p)); }
+      static void store(char* p, const V v) { _mm256_storeu_si256(reinterpret_cast<V*>(p), v); }
+      static V zero() { return _mm256_setzero_si256(); }
+      static V set1(const char value) { return _mm256_set1_epi8(value); }
+      static V add(const V a, const V b) { return _mm256_add_epi8(a, b); }
+      static V sub(const V a, const V b) { return _mm256_sub_epi8(a, b); }
+      static V bit_and(const V a, const V b) { return _mm256_and_si256(a, b); }
+      static V bit_andnot(const V a, const V b) { return _mm256_andnot_si256(a, b); }
+      static V bit_or(const V a, const V b) { return _mm256_or_si256(a, b); }
+      static V bit_xor(const V a, const V b) { return _mm256_xor_si256(a, b); }
+      static V cmpeq(const V a, const V b) { return _mm256_cmpeq_epi8(a, b); }
+      static V cmpgt(const V a, const V b) { return _mm256_cmpgt_epi8(a, b); }
+      static uint64_t movemask(const V v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+
+      static V color_mask(const int parity) {
+         return parity == 0 ? _mm256_set1_epi16(0x00FF) : _mm256_set1_epi16(static_cast<short>(0xFF00));
+      }
+
+      static Table make_table(const uint8_t* threshold_bytes) {
+         const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(threshold_bytes));
+         return { _mm256_broadcastsi128_si256(half), _mm256_set1_epi8(4) };
+      }
+
+      static V lookup(const Table& table, const V prod) {
+         return _mm256_shuffle_epi8(table.thresholds, _mm256_add_epi8(prod, table.offset));
+      }
+
+      static V load_state(const uint64_t* state) { return _mm256_loadu_si256(reinterpret_cast<const V*>(state)); }
+      static void store_state(uint64_t* state, const V v) { _mm256_storeu_si256(reinterpret_cast<V*>(state), v); }
+
+      /// <summary>xorshift128+ on every 64 bit lane</summary>
+      static V random(V& s0, V& s1) {
+         V x = s0;
+         const V y = s1;
+         s0 = y;
+         x = _mm256_xor_si256(x, _mm256_slli_epi64(x, 23));
+         s1 = _mm256_xor_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(_mm256_srli_epi64(x, 17), _mm256_srli_epi64(y, 26)));
+         return _mm256_add_epi64(s1, y);
+      }
+   };
+
+} // namespace {}
+
+#include "SimdMetropolisKernel.hpp"
+
+
+void magneto::simd_sweep_color_avx2(SimdSweepData& data, const int color) {
+   sweep_color<AVX2Ops>(data, color);
+}
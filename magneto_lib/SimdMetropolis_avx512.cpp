@@ -0,0 +1,68 @@
+#include "SimdMetropolisKernel.h"
+
+#include <immintrin.h>
+
+
+namespace {
+
+   /// <summary>AVX-512BW primitives. Comparisons are turned back into byte masks so the kernel
+   /// body can stay the same for all instruction sets.</summary>
+   struct AVX512Ops {
+      using V = __m512i;
+      static constexpr int width = 64;
+
+      /// <summary>Thresholds broadcast into all four 128 bit lanes for the byte shuffle</summary>
+      struct Table {
+         V thresholds;
+         V offset;
+      };
+
+      static V load(const char* p) { return _mm512_loadu_si512(p); }
+      static void store(char* p, const V v) { _mm512_storeu_si512(p, v); }
+      static V zero() { return _mm512_setzero_si512(); }
+      static V set1(const char value) { return _mm512_set1_epi8(value); }
+      static V add(const V a, const V b) { return _mm512_add_epi8(a, b); }
+      static V sub(const V a, const V b) { return _mm512_sub_epi8(a, b); }
+      static V bit_and(const V a, const V b) { return _mm512_and_si512(a, b); }
+      static V bit_andnot(const V a, const V b) { return _mm512_andnot_si512(a, b); }
+      static V bit_or(const V a, const V b) { return _mm512_or_si512(a, b); }
+      static V bit_xor(const V a, const V b) { return _mm512_xor_si512(a, b); }
+      static V cmpeq(const V a, const V b) { return _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(a, b)); }
+      static V cmpgt(const V a, const V b) { return _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(a, b)); }
+      static uint64_t movemask(const V v) { return _mm512_movepi8_mask(v); }
+
+      static V color_mask(const int parity) {
+         return parity == 0 ? _mm512_set1_epi16(0x00FF) : _mm512_set1_epi16(static_cast<short>(0xFF00));
+      }
+
+      static Table make_table(const uint8_t* threshold_bytes) {
+         const __m128i lane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(threshold_bytes));
+         return { _mm512_broadcast_i32x4(lane), _mm512_set1_epi8(4) };
+      }
+
+      static V lookup(const Table& table, const V prod) {
+         return _mm512_shuffle_epi8(table.thresholds, _mm512_add_epi8(prod, table.offset));
+      }
+
+      static V load_state(const uint64_t* state) { return _mm512_loadu_si512(state); }
+      static void store_state(uint64_t* state, const V v) { _mm512_storeu_si512(state, v); }
+
+      /// <summary>xorshift128+ on every 64 bit lane</summary>
+      static V random(V& s0, V& s1) {
+         V x = s0;
+         const V y = s1;
+         s0 = y;
+         x = _mm512_xor_si512(x, _mm512_slli_epi64(x, 23));
+         s1 = _mm512_xor_si512(_mm512_xor_si512(x, y), _mm512_xor_si512(_mm512_srli_epi64(x, 17), _mm512_srli_epi64(y, 26)));
+         return _mm512_add_epi64(s1, y);
+      }
+   };
+
+} // namespace {}
+
+#include "SimdMetropolisKernel.hpp"
+
+
+void magneto::simd_sweep_color_avx512(SimdSweepData& data, const int color) {
+   sweep_color<AVX512Ops>(data, color);
+}
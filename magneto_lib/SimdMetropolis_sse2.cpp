@@ -0,0 +1,74 @@
+#include "SimdMetropolisKernel.h"
+
+#include <emmintrin.h>
+
+
+namespace {
+
+   struct SSE2Ops {
+      using V = __m128i;
+      static constexpr int width = 16;
+
+      /// <summary>No byte shuffle in SSE2, the two uphill thresholds are blended in instead</summary>
+      struct Table {
+         V prod_two;
+         V prod_four;
+         V threshold_two;
+         V threshold_four;
+      };
+
+      static V load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const V*>(p)); }
+      static void store(char* p, const V v) { _mm_storeu_si128(reinterpret_cast<V*>(p), v); }
+      static V zero() { return _mm_setzero_si128(); }
+      static V set1(const char value) { return _mm_set1_epi8(value); }
+      static V add(const V a, const V b) { return _mm_add_epi8(a, b); }
+      static V sub(const V a, const V b) { return _mm_sub_epi8(a, b); }
+      static V bit_and(const V a, const V b) { return _mm_and_si128(a, b); }
+      static V bit_andnot(const V a, const V b) { return _mm_andnot_si128(a, b); }
+      static V bit_or(const V a, const V b) { return _mm_or_si128(a, b); }
+      static V bit_xor(const V a, const V b) { return _mm_xor_si128(a, b); }
+      static V cmpeq(const V a, const V b) { return _mm_cmpeq_epi8(a, b); }
+      static V cmpgt(const V a, const V b) { return _mm_cmpgt_epi8(a, b); }
+      static uint64_t movemask(const V v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+
+      static V color_mask(const int parity) {
+         return parity == 0 ? _mm_set1_epi16(0x00FF) : _mm_set1_epi16(static_cast<short>(0xFF00));
+      }
+
+      static Table make_table(const uint8_t* threshold_bytes) {
+         return {
+            _mm_set1_epi8(2), _mm_set1_epi8(4),
+            _mm_set1_epi8(static_cast<char>(threshold_bytes[2 + 4])),
+            _mm_set1_epi8(static_cast<char>(threshold_bytes[4 + 4]))
+         };
+      }
+
+      static V lookup(const Table& table, const V prod) {
+         return _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(prod, table.prod_two), table.threshold_two),
+            _mm_and_si128(_mm_cmpeq_epi8(prod, table.prod_four), table.threshold_four)
+         );
+      }
+
+      static V load_state(const uint64_t* state) { return _mm_loadu_si128(reinterpret_cast<const V*>(state)); }
+      static void store_state(uint64_t* state, const V v) { _mm_storeu_si128(reinterpret_cast<V*>(state), v); }
+
+      /// <summary>xorshift128+ on every 64 bit lane</summary>
+      static V random(V& s0, V& s1) {
+         V x = s0;
+         const V y = s1;
+         s0 = y;
+         x = _mm_xor_si128(x, _mm_slli_epi64(x, 23));
+         s1 = _mm_xor_si128(_mm_xor_si128(x, y), _mm_xor_si128(_mm_srli_epi64(x, 17), _mm_srli_epi64(y, 26)));
+         return _mm_add_epi64(s1, y);
+      }
+   };
+
+} // namespace {}
+
+#include "SimdMetropolisKernel.hpp"
+
+
+void magneto::simd_sweep_color_sse2(SimdSweepData& data, const int color) {
+   sweep_color<SSE2Ops>(data, color);
+}
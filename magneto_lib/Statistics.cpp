@@ -0,0 +1,297 @@
+#include "Statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+   /// <summary>Blocks a level needs for its error to count towards the plateau</summary>
+   constexpr uint64_t min_blocks_for_error = 32;
+
+   constexpr size_t jackknife_bin_count = 64;
+
+   /// <summary>Window of the autocorrelation sum in units of tau_int, Sokal recommends 4 to 10</summary>
+   constexpr double sokal_window_factor = 6.0;
+
+   constexpr size_t mser_batch_size = 5;
+
+   /// <summary>Cuts have to leave this many batches, the last few ones have a small variance by chance</summary>
+   constexpr size_t mser_min_remaining_batches = 10;
+
+} // namespace {}
+
+
+
+void magneto::KahanSum::add(const double value) {
+   const double corrected = value - m_compensation;
+   const double sum = m_sum + corrected;
+   m_compensation = (sum - m_sum) - corrected;
+   m_sum = sum;
+}
+
+
+void magneto::KahanSum::merge(const KahanSum& other) {
+   add(other.m_sum);
+   add(-other.m_compensation);
+}
+
+
+double magneto::KahanSum::get() const {
+   return m_sum;
+}
+
+
+void magneto::RunningMoments::add(const double value) {
+   ++m_count;
+   const double delta = value - m_mean;
+   m_mean += delta / m_count;
+   m_squared_deviations += delta * (value - m_mean);
+}
+
+
+void magneto::RunningMoments::merge(const RunningMoments& other) {
+   if (other.m_count == 0)
+      return;
+   if (m_count == 0) {
+      *this = other;
+      return;
+   }
+   const uint64_t count = m_count + other.m_count;
+   const double delta = other.m_mean - m_mean;
+   m_mean += delta * other.m_count / count;
+   m_squared_deviations += other.m_squared_deviations + delta * delta * m_count / count * other.m_count;
+   m_count = count;
+}
+
+
+uint64_t magneto::RunningMoments::get_count() const {
+   return m_count;
+}
+
+
+double magneto::RunningMoments::get_mean() const {
+   return m_mean;
+}
+
+
+double magneto::RunningMoments::get_variance() const {
+   return m_count > 0 ? m_squared_deviations / m_count : 0.0;
+}
+
+
+void magneto::BlockingAnalysis::add(double value) {
+   for (size_t level = 0; ; ++level) {
+      if (level == m_levels.size())
+         m_levels.emplace_back();
+      Level& current = m_levels[level];
+      current.m_block_means.add(value);
+      if (!current.m_has_pending) {
+         current.m_pending = value;
+         current.m_has_pending = true;
+         return;
+      }
+      value = 0.5 * (current.m_pending + value);
+      current.m_has_pending = false;
+   }
+}
+
+
+void magneto::BlockingAnalysis::merge(const BlockingAnalysis& other) {
+   if (m_levels.size() < other.m_levels.size())
+      m_levels.resize(other.m_levels.size());
+   for (size_t level = 0; level < other.m_levels.size(); ++level)
+      m_levels[level].m_block_means.merge(other.m_levels[level].m_block_means);
+}
+
+
+double magneto::BlockingAnalysis::get_error() const {
+   double error = 0.0;
+   for (size_t level = 0; level < m_levels.size(); ++level) {
+      const RunningMoments& blocks = m_levels[level].m_block_means;
+      if (blocks.get_count() < 2 || (level > 0 && blocks.get_count() < min_blocks_for_error))
+         continue;
+      error = std::max(error, std::sqrt(blocks.get_variance() / (blocks.get_count() - 1)));
+   }
+   return error;
+}
+
+
+void magneto::JackknifeBins::add(const double value) {
+   if (!m_has_shift) {
+      m_shift = value;
+      m_has_shift = true;
+   }
+   const double shifted = value - m_shift;
+   if (m_bins.empty() || m_bins.back().m_count == m_bin_size) {
+      if (m_bins.size() == jackknife_bin_count)
+         halve_bins();
+      if (m_bins.empty() || m_bins.back().m_count == m_bin_size)
+         m_bins.emplace_back();
+   }
+   Bin& bin = m_bins.back();
+   ++bin.m_count;
+   bin.m_sum += shifted;
+   bin.m_squared_sum += shifted * shifted;
+}
+
+
+void magneto::JackknifeBins::merge(const JackknifeBins& other) {
+   if (!other.m_has_shift)
+      return;
+   if (!m_has_shift) {
+      *this = other;
+      return;
+   }
+   // Re-express the other bins relative to this shift: (x - s) = (x - s_other) + d
+   const double d = other.m_shift - m_shift;
+   while (m_bin_size < other.m_bin_size)
+      halve_bins();
+   for (const Bin& other_bin : other.m_bins) {
+      Bin bin;
+      bin.m_count = other_bin.m_count;
+      bin.m_sum = other_bin.m_sum + d * other_bin.m_count;
+      bin.m_squared_sum = other_bin.m_squared_sum + 2.0 * d * other_bin.m_sum + d * d * other_bin.m_count;
+      add_bin(bin);
+   }
+}
+
+
+double magneto::JackknifeBins::get_variance_error() const {
+   const size_t bins = m_bins.size();
+   if (bins < 2)
+      return 0.0;
+   Bin total;
+   for (const Bin& bin : m_bins) {
+      total.m_count += bin.m_count;
+      total.m_sum += bin.m_sum;
+      total.m_squared_sum += bin.m_squared_sum;
+   }
+   std::vector<double> estimates;
+   estimates.reserve(bins);
+   for (const Bin& bin : m_bins) {
+      const double count = static_cast<double>(total.m_count - bin.m_count);
+      const double mean = (total.m_sum - bin.m_sum) / count;
+      estimates.emplace_back((total.m_squared_sum - bin.m_squared_sum) / count - mean * mean);
+   }
+   double estimate_mean = 0.0;
+   for (const double estimate : estimates)
+      estimate_mean += estimate / bins;
+   double squared_deviations = 0.0;
+   for (const double estimate : estimates)
+      squared_deviations += (estimate - estimate_mean) * (estimate - estimate_mean);
+   return std::sqrt((bins - 1.0) / bins * squared_deviations);
+}
+
+
+void magneto::JackknifeBins::add_bin(const Bin& bin) {
+   if (m_bins.size() == jackknife_bin_count)
+      halve_bins();
+   m_bins.emplace_back(bin);
+}
+
+
+void magneto::JackknifeBins::halve_bins() {
+   std::vector<Bin> merged;
+   merged.reserve(jackknife_bin_count);
+   for (size_t k = 0; k < m_bins.size(); k += 2) {
+      Bin bin = m_bins[k];
+      if (k + 1 < m_bins.size()) {
+         bin.m_count += m_bins[k + 1].m_count;
+         bin.m_sum += m_bins[k + 1].m_sum;
+         bin.m_squared_sum += m_bins[k + 1].m_squared_sum;
+      }
+      merged.emplace_back(bin);
+   }
+   m_bins = std::move(merged);
+   m_bin_size *= 2;
+}
+
+
+size_t magneto::get_mser_truncation(const std::vector<double>& series) {
+   const size_t batches = series.size() / mser_batch_size;
+   if (batches < mser_min_remaining_batches)
+      return series.size();
+
+   // Batch means relative to the last value, summed from the end for all cuts at once
+   const double shift = series.back();
+   std::vector<double> batch_means(batches, 0.0);
+   for (size_t k = 0; k < batches * mser_batch_size; ++k)
+      batch_means[k / mser_batch_size] += (series[k] - shift) / mser_batch_size;
+
+   double sum = 0.0, squared_sum = 0.0;
+   double best_mser = std::numeric_limits<double>::infinity();
+   size_t best_cut = batches;
+   for (size_t cut = batches; cut-- > 0; ) {
+      sum += batch_means[cut];
+      squared_sum += batch_means[cut] * batch_means[cut];
+      const double count = static_cast<double>(batches - cut);
+      if (batches - cut < mser_min_remaining_batches)
+         continue;
+      const double mean = sum / count;
+      const double mser = std::max(0.0, squared_sum / count - mean * mean) / count;
+      if (mser <= best_mser) {
+         best_mser = mser;
+         best_cut = cut;
+      }
+   }
+   return best_cut * mser_batch_size;
+}
+
+
+double magneto::get_integrated_autocorrelation_time(const std::vector<double>& series) {
+   const size_t n = series.size();
+   RunningMoments moments;
+   for (const double value : series)
+      moments.add(value);
+   const double variance = moments.get_variance();
+   if (n < 2 || variance <= 0.0)
+      return 0.5;
+
+   double tau = 0.5;
+   for (size_t lag = 1; lag < n; ++lag) {
+      double covariance = 0.0;
+      for (size_t k = 0; k + lag < n; ++k)
+         covariance += (series[k] - moments.get_mean()) * (series[k + lag] - moments.get_mean());
+      tau += covariance / (n - lag) / variance;
+      if (lag >= sokal_window_factor * tau)
+         break;
+   }
+   return std::max(0.5, tau);
+}
+
+
+void magneto::MeasurementStatistics::add(const double energy, const double magnetization) {
+   m_energy.add(energy);
+   m_magnetization.add(magnetization);
+   const double m2 = magnetization * magnetization;
+   m_m2_sum.add(m2);
+   m_m4_sum.add(m2 * m2);
+   m_energy_blocking.add(energy);
+   m_magnetization_blocking.add(magnetization);
+   m_energy_bins.add(energy);
+   m_magnetization_bins.add(magnetization);
+}
+
+
+void magneto::MeasurementStatistics::merge(const MeasurementStatistics& other) {
+   m_energy.merge(other.m_energy);
+   m_magnetization.merge(other.m_magnetization);
+   m_m2_sum.merge(other.m_m2_sum);
+   m_m4_sum.merge(other.m_m4_sum);
+   m_energy_blocking.merge(other.m_energy_blocking);
+   m_magnetization_blocking.merge(other.m_magnetization_blocking);
+   m_energy_bins.merge(other.m_energy_bins);
+   m_magnetization_bins.merge(other.m_magnetization_bins);
+}
+
+
+double magneto::MeasurementStatistics::get_binder_cumulant() const {
+   const uint64_t count = m_magnetization.get_count();
+   const double m2_mean = count > 0 ? m_m2_sum.get() / count : 0.0;
+   if (m2_mean <= 0.0)
+      return 0.0;
+   const double m4_mean = m_m4_sum.get() / count;
+   return 1.0 - m4_mean / (3.0 * m2_mean * m2_mean);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "export_macro.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace magneto {
+
+   /// <summary>Sum with Kahan compensation, so millions of small terms don't lose their low bits</summary>
+   class CLASS_DECLSPEC KahanSum {
+   public:
+      void add(const double value);
+      void merge(const KahanSum& other);
+      [[nodiscard]] double get() const;
+
+   private:
+      double m_sum = 0.0;
+      double m_compensation = 0.0;
+   };
+
+
+   /// <summary>Count, mean and summed squared deviation of a series, updated with Welford's method
+   /// <para>Two of them merge into exactly what the concatenated series would have given (Chan et al.),
+   /// so partial results of threads or replicas can be combined.</para>
+   /// </summary>
+   class CLASS_DECLSPEC RunningMoments {
+   public:
+      void add(const double value);
+      void merge(const RunningMoments& other);
+      [[nodiscard]] uint64_t get_count() const;
+      [[nodiscard]] double get_mean() const;
+
+      /// <summary>Population variance, like mean(x^2) - mean(x)^2</summary>
+      [[nodiscard]] double get_variance() const;
+
+   private:
+      uint64_t m_count = 0;
+      double m_mean = 0.0;
+      double m_squared_deviations = 0.0;
+   };
+
+
+   /// <summary>Online blocking analysis (Flyvbjerg-Petersen) for the error of a correlated mean
+   /// <para>Level k holds the moments of the means of 2^k consecutive values, so the memory is
+   /// O(log n). The blocks of one level get less correlated with every level, until their naive
+   /// error reaches a plateau at the true error.</para>
+   /// </summary>
+   class CLASS_DECLSPEC BlockingAnalysis {
+   public:
+      void add(const double value);
+
+      /// <summary>Pools the blocks of an independent series. Unpaired values are dropped.</summary>
+      void merge(const BlockingAnalysis& other);
+
+      /// <summary>Largest error of all levels with enough blocks, as an estimate of the plateau</summary>
+      [[nodiscard]] double get_error() const;
+
+   private:
+      struct Level {
+         RunningMoments m_block_means;
+         double m_pending = 0.0;
+         bool m_has_pending = false;
+      };
+      std::vector<Level> m_levels;
+   };
+
+
+   /// <summary>Jackknife error of the variance of a correlated series, as needed for cv and chi
+   /// <para>The values go into a fixed number of bins. Once all bins are full, neighbouring bins are
+   /// merged and the bin size doubles, so the bins eventually get longer than the correlation time.
+   /// Values are stored relative to the first one to keep the sums of squares well-conditioned.</para>
+   /// </summary>
+   class JackknifeBins {
+   public:
+      void add(const double value);
+
+      /// <summary>Appends the bins of an independent series</summary>
+      void merge(const JackknifeBins& other);
+
+      [[nodiscard]] double get_variance_error() const;
+
+   private:
+      struct Bin {
+         uint64_t m_count = 0;
+         double m_sum = 0.0;
+         double m_squared_sum = 0.0;
+      };
+      void add_bin(const Bin& bin);
+      void halve_bins();
+
+      std::vector<Bin> m_bins;
+      uint64_t m_bin_size = 1;
+      double m_shift = 0.0;
+      bool m_has_shift = false;
+   };
+
+
+   /// <summary>Start of the stationary part of a series by the MSER-5 rule
+   /// <para>The series is cut at the batch boundary that minimizes the squared standard error of the
+   /// remaining mean. A cut in the first half means the series has become stationary, a later one
+   /// that it is still drifting.</para>
+   /// </summary>
+   [[nodiscard]] CLASS_DECLSPEC size_t get_mser_truncation(const std::vector<double>& series);
+
+
+   /// <summary>Integrated autocorrelation time of a series with Sokal's automatic windowing
+   /// <para>tau_int = 1/2 + sum of the normalized autocorrelations up to lag M, with M the first lag
+   /// beyond 6 tau_int. Uncorrelated series give 1/2, the squared error of the mean is 2 tau_int
+   /// times the naive one.</para>
+   /// </summary>
+   [[nodiscard]] double get_integrated_autocorrelation_time(const std::vector<double>& series);
+
+
+   /// <summary>Constant-memory statistics of the per-site energy and absolute magnetization at one
+   /// temperature. m^2 and m^4 are kept as compensated raw sums for moment ratios like the Binder
+   /// cumulant. Blocking and jackknife bins give the errors.</summary>
+   struct CLASS_DECLSPEC MeasurementStatistics {
+      void add(const double energy, const double magnetization);
+      void merge(const MeasurementStatistics& other);
+
+      /// <summary>U4 = 1 - <m^4>/(3<m^2>^2), zero without measurements</summary>
+      [[nodiscard]] double get_binder_cumulant() const;
+
+      RunningMoments m_energy;
+      RunningMoments m_magnetization;
+      KahanSum m_m2_sum;
+      KahanSum m_m4_sum;
+      BlockingAnalysis m_energy_blocking;
+      BlockingAnalysis m_magnetization_blocking;
+      JackknifeBins m_energy_bins;
+      JackknifeBins m_magnetization_bins;
+   };
+}
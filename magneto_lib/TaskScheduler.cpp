@@ -0,0 +1,107 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+
+magneto::TaskScheduler::TaskScheduler(const unsigned int workers, const std::function<void(unsigned int)>& on_start) {
+   const unsigned int worker_count = std::max(workers, 1u);
+   for (unsigned int i = 0; i < worker_count; ++i)
+      m_queues.emplace_back(std::make_unique<WorkerQueue>());
+   for (unsigned int i = 0; i < worker_count; ++i) {
+      m_workers.emplace_back([this, i, on_start] {
+         if (on_start)
+            on_start(i);
+         work(i);
+      });
+   }
+}
+
+
+magneto::TaskScheduler::~TaskScheduler() {
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+   }
+   m_work_available.notify_all();
+   for (std::thread& worker : m_workers)
+      worker.join();
+}
+
+
+void magneto::TaskScheduler::run(std::vector<Task> tasks) {
+   if (tasks.empty())
+      return;
+   std::stable_sort(std::begin(tasks), std::end(tasks), [](const Task& a, const Task& b) {return a.m_cost > b.m_cost; });
+
+   // Workers of the last run can still be looking for tasks, so the count has to be set first
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pending = tasks.size();
+   }
+   for (size_t k = 0; k < tasks.size(); ++k) {
+      WorkerQueue& queue = *m_queues[k % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.m_mutex);
+      queue.m_tasks.emplace_back(std::move(tasks[k].m_work));
+   }
+
+   std::unique_lock<std::mutex> lock(m_mutex);
+   ++m_generation;
+   m_work_available.notify_all();
+   m_all_done.wait(lock, [this] {return m_pending == 0; });
+}
+
+
+unsigned int magneto::TaskScheduler::get_worker_count() const {
+   return static_cast<unsigned int>(m_workers.size());
+}
+
+
+unsigned long long magneto::TaskScheduler::get_steal_count() const {
+   return m_steals;
+}
+
+
+void magneto::TaskScheduler::work(const size_t worker) {
+   unsigned long long seen_generation = 0;
+   while (true) {
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         m_work_available.wait(lock, [&] {return m_stop || m_generation != seen_generation; });
+         if (m_stop)
+            return;
+         seen_generation = m_generation;
+      }
+      // Tasks never add tasks, so once all queues are empty this worker is done with the run
+      while (const std::function<void()> task = get_next_task(worker)) {
+         task();
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if (--m_pending == 0)
+            m_all_done.notify_all();
+      }
+   }
+}
+
+
+std::function<void()> magneto::TaskScheduler::get_next_task(const size_t worker) {
+   std::function<void()> task;
+   {
+      WorkerQueue& own = *m_queues[worker];
+      std::lock_guard<std::mutex> lock(own.m_mutex);
+      if (!own.m_tasks.empty()) {
+         task = std::move(own.m_tasks.front());
+         own.m_tasks.pop_front();
+         return task;
+      }
+   }
+   for (size_t offset = 1; offset < m_queues.size(); ++offset) {
+      WorkerQueue& victim = *m_queues[(worker + offset) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(victim.m_mutex);
+      if (victim.m_tasks.empty())
+         continue;
+      task = std::move(victim.m_tasks.back());
+      victim.m_tasks.pop_back();
+      ++m_steals;
+      return task;
+   }
+   return task;
+}
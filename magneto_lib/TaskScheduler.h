@@ -0,0 +1,63 @@
+#pragma once
+
+#include "export_macro.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace magneto {
+
+   /// <summary>Unit of work for the TaskScheduler, the cost is only compared between tasks</summary>
+   struct Task {
+      double m_cost = 1.0;
+      std::function<void()> m_work;
+   };
+
+
+   /// <summary>Fixed set of workers with one task queue each and work stealing between them
+   /// <para>run() sorts the tasks by expected cost and deals them out longest first, so the expensive
+   /// ones start right away instead of forming a tail at the end. Every worker takes the largest task
+   /// of its own queue. An idle worker steals the smallest task of another queue, which evens out
+   /// costs that were estimated wrong.</para>
+   /// </summary>
+   class CLASS_DECLSPEC TaskScheduler {
+   public:
+      /// <summary>on_start is called first on every worker thread, with the index of the worker</summary>
+      explicit TaskScheduler(const unsigned int workers, const std::function<void(unsigned int)>& on_start = {});
+      ~TaskScheduler();
+      TaskScheduler(const TaskScheduler&) = delete;
+      TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+      /// <summary>Runs all tasks and returns once they are done. Not reentrant.</summary>
+      void run(std::vector<Task> tasks);
+
+      [[nodiscard]] unsigned int get_worker_count() const;
+      [[nodiscard]] unsigned long long get_steal_count() const;
+
+   private:
+      struct WorkerQueue {
+         std::mutex m_mutex;
+         std::deque<std::function<void()>> m_tasks;
+      };
+      void work(const size_t worker);
+      [[nodiscard]] std::function<void()> get_next_task(const size_t worker);
+
+      std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+      std::vector<std::thread> m_workers;
+      std::mutex m_mutex;
+      std::condition_variable m_work_available;
+      std::condition_variable m_all_done;
+      size_t m_pending = 0;
+      unsigned long long m_generation = 0;
+      bool m_stop = false;
+
+      std::atomic<unsigned long long> m_steals = 0;
+   };
+}
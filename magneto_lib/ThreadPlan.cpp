@@ -0,0 +1,95 @@
+#include "ThreadPlan.h"
+#include "MultiSpinMetropolis.h"
+#include "cpu_tools.h"
+#include "logging.h"
+
+#include <algorithm>
+
+
+namespace {
+
+   /// <summary>Lattices with buffered SW that one RNG thread can keep supplied</summary>
+   constexpr unsigned int lattices_per_rng_thread = 8;
+   constexpr unsigned int max_rng_threads = 4;
+
+   /// <summary>Below this many sites per thread, the OpenMP fork and barriers cost more than the
+   /// threads gain within one sweep</summary>
+   constexpr unsigned int min_sites_per_lattice_thread = 128 * 128;
+
+
+   bool uses_rng_pool(const magneto::Job& job) {
+      return job.m_algorithm == magneto::Algorithm::SW && job.m_random_mode == magneto::RandomMode::Buffered;
+   }
+
+
+   bool is_parallel_within_lattice(const magneto::Job& job) {
+      if (job.m_algorithm == magneto::Algorithm::ParallelSW)
+         return true;
+      return job.m_algorithm == magneto::Algorithm::CheckerboardMetropolis && magneto::is_checkerboard_compatible(job.m_Lx, job.m_Ly);
+   }
+
+} // namespace {}
+
+
+magneto::ThreadPlan magneto::get_thread_plan(const Job& job, const size_t task_count) {
+   const std::vector<unsigned int> usable_cores = get_usable_cores();
+   ThreadPlan plan;
+   plan.m_budget = job.m_threads > 0 ? job.m_threads : static_cast<unsigned int>(usable_cores.size());
+
+   const unsigned int tasks = static_cast<unsigned int>(std::max<size_t>(task_count, 1));
+   if (uses_rng_pool(job)) {
+      const unsigned int lanes = std::min(tasks, plan.m_budget);
+      plan.m_rng_threads = std::clamp((lanes + lattices_per_rng_thread - 1) / lattices_per_rng_thread, 1u, max_rng_threads);
+      plan.m_rng_threads = std::min(plan.m_rng_threads, std::max(plan.m_budget / 2, 1u));
+   }
+   const unsigned int compute_threads = std::max(plan.m_budget - std::min(plan.m_rng_threads, plan.m_budget), 1u);
+
+   // Temperatures are independent and scale perfectly, so they get the threads first
+   if (!is_parallel_within_lattice(job)) {
+      if (job.m_algorithm_threads > 0)
+         get_logger()->warn("algorithm_threads has no effect on this algorithm.");
+      plan.m_temperature_threads = std::min(tasks, compute_threads);
+      plan.m_lattice_threads = 1;
+   }
+   else if (job.m_algorithm_threads > 0) {
+      if (job.m_algorithm_threads > compute_threads)
+         get_logger()->warn("algorithm_threads={} exceeds the thread budget, using {}.", job.m_algorithm_threads, compute_threads);
+      plan.m_lattice_threads = std::min(job.m_algorithm_threads, compute_threads);
+      plan.m_temperature_threads = std::clamp(compute_threads / plan.m_lattice_threads, 1u, tasks);
+   }
+   else {
+      const unsigned int useful_lattice_threads = std::max(job.m_Lx * job.m_Ly / min_sites_per_lattice_thread, 1u);
+      plan.m_temperature_threads = std::min(tasks, compute_threads);
+      plan.m_lattice_threads = std::clamp(compute_threads / plan.m_temperature_threads, 1u, useful_lattice_threads);
+   }
+
+   const unsigned int planned_threads = plan.m_rng_threads + plan.m_temperature_threads * plan.m_lattice_threads;
+   plan.m_pin = job.m_pin_threads && planned_threads <= usable_cores.size();
+   if (job.m_pin_threads && !plan.m_pin)
+      get_logger()->info("Not pinning threads, the plan needs {} threads for {} cores.", planned_threads, usable_cores.size());
+   return plan;
+}
+
+
+void magneto::log_thread_plan(const ThreadPlan& plan) {
+   get_logger()->info(
+      "Thread budget {}: {} temperatures at once with {} lattice threads each, {} RNG threads{}",
+      plan.m_budget, plan.m_temperature_threads, plan.m_lattice_threads, plan.m_rng_threads, plan.m_pin ? ", pinned" : ""
+   );
+}
+
+
+void magneto::pin_temperature_worker(const ThreadPlan& plan, const unsigned int worker) {
+   if (!plan.m_pin)
+      return;
+   if (!pin_current_thread(plan.m_rng_threads + worker * plan.m_lattice_threads, plan.m_lattice_threads))
+      get_logger()->warn("Could not pin temperature worker {}.", worker);
+}
+
+
+void magneto::pin_rng_worker(const ThreadPlan& plan, const unsigned int worker) {
+   if (!plan.m_pin)
+      return;
+   if (!pin_current_thread(worker, 1))
+      get_logger()->warn("Could not pin RNG worker {}.", worker);
+}
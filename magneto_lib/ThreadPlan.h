@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Job.h"
+
+
+namespace magneto {
+
+   /// <summary>Split of the thread budget of a job between its three kinds of parallelism
+   /// <para>Temperature threads are the workers of the TaskScheduler, each runs one temperature (or
+   /// replica, chain, Wang-Landau window) at a time. Every one of them can use lattice_threads
+   /// threads within its lattice with the parallel algorithms. The RNG threads fill the random
+   /// buffers of the buffered SW. Together they never use more than the budget, except that the
+   /// buffered SW always gets one RNG thread.</para>
+   /// <para>With pinning, the RNG threads get the first cores and every temperature worker the
+   /// next lattice_threads cores, which its OpenMP team inherits where the runtime supports it.</para>
+   /// </summary>
+   struct ThreadPlan {
+      unsigned int m_budget = 1;
+      unsigned int m_temperature_threads = 1;
+      unsigned int m_lattice_threads = 1;
+      unsigned int m_rng_threads = 0;
+      bool m_pin = false;
+   };
+
+   /// <summary>Plan for a job that runs task_count independent temperatures or windows</summary>
+   CLASS_DECLSPEC ThreadPlan get_thread_plan(const Job& job, const size_t task_count);
+
+   void log_thread_plan(const ThreadPlan& plan);
+
+   /// <summary>To be called first on the given worker thread of the TaskScheduler or RngPool. Does
+   /// nothing without pinning.</summary>
+   void pin_temperature_worker(const ThreadPlan& plan, const unsigned int worker);
+   void pin_rng_worker(const ThreadPlan& plan, const unsigned int worker);
+}
@@ -67,17 +67,17 @@ namespace {
 
 
 	/// <summary>Fills the buffer with the grid data. Output is in [0,255] range.</summary>
-	void add_grid_to_buffer(magneto::LatticeIType& buffer, const magneto::LatticeType& grid) {
+	void add_grid_to_buffer(magneto::LatticeIType& buffer, const magneto::SpinLattice& grid) {
       const auto [Lx, Ly] = magneto::get_dimensions_of_lattice(grid);
 		for (unsigned int i = 0; i < Ly; ++i) {
 			for (unsigned int j = 0; j < Lx; ++j) {
-				buffer[i][j] += get_255_value_from_pm_one(grid[i][j]);
+				buffer[i][j] += get_255_value_from_pm_one(grid(i, j));
 			}
 		}
 	}
 
 
-	magneto::LatticeIType get_png_buffer_from_lattice(const magneto::LatticeType& grid) {
+	magneto::LatticeIType get_png_buffer_from_lattice(const magneto::SpinLattice& grid) {
       const auto [Lx, Ly] = magneto::get_dimensions_of_lattice(grid);
 		magneto::LatticeIType png_buffer(Ly, std::vector<int>(Lx));
 		add_grid_to_buffer(png_buffer, grid);
@@ -101,7 +101,7 @@ magneto::MovieWriter::MovieWriter(const size_t Lx, const size_t Ly, const magnet
 }
 
 
-void magneto::MovieWriter::snapshot(const LatticeType& grid, const bool /*last_frame*/){
+void magneto::MovieWriter::snapshot(const SpinLattice& grid, const bool /*last_frame*/){
 	m_buffer.add(grid);
 	m_framecount++;
 
@@ -143,7 +143,7 @@ magneto::IntervalWriter::IntervalWriter(const size_t /*Lx*/, const size_t /*Ly*/
 {}
 
 
-void magneto::IntervalWriter::snapshot(const LatticeType& grid, const bool /*last_frame*/){
+void magneto::IntervalWriter::snapshot(const SpinLattice& grid, const bool /*last_frame*/){
    ++m_framecount;
 
    if (m_framecount % m_frame_intervals == 0) {
@@ -162,7 +162,7 @@ magneto::TemporalAverageLattice::TemporalAverageLattice(const size_t Lx, const s
 {}
 
 
-void magneto::TemporalAverageLattice::add(const LatticeType & grid){
+void magneto::TemporalAverageLattice::add(const SpinLattice& grid){
 	add_grid_to_buffer(m_buffer, grid);
 	++m_recorded_frames;
 }
@@ -194,7 +194,7 @@ magneto::EndImageWriter::EndImageWriter(const size_t /*Lx*/, const size_t /*Ly*/
    : m_output_filename(get_movie_filename(image_mode.m_path, temp_string))
 {}
 
-void magneto::EndImageWriter::snapshot(const LatticeType& grid, const bool last_frame){
+void magneto::EndImageWriter::snapshot(const SpinLattice& grid, const bool last_frame){
    if (!last_frame)
       return;
    write_png(get_png_buffer_from_lattice(grid), m_output_filename);
@@ -208,7 +208,7 @@ void magneto::EndImageWriter::end_actions()
 magneto::NullImageWriter::NullImageWriter(const size_t /*Lx*/, const size_t /*Ly*/, const ImageMode& /*image_mode*/, const std::string& /*temp_string*/)
 {}
 
-void magneto::NullImageWriter::snapshot(const LatticeType& /*grid*/, const bool /*last_frame*/)
+void magneto::NullImageWriter::snapshot(const SpinLattice& /*grid*/, const bool /*last_frame*/)
 {}
 
 void magneto::NullImageWriter::end_actions()
@@ -7,7 +7,7 @@ namespace magneto {
 
    class VisualOutput {
    public:
-      virtual void snapshot(const LatticeType& grid, const bool last_frame = false) = 0;
+      virtual void snapshot(const SpinLattice& grid, const bool last_frame = false) = 0;
       virtual void end_actions() = 0;
    };
 
@@ -17,7 +17,7 @@ namespace magneto {
       TemporalAverageLattice(const size_t Lx, const size_t Ly);
 
       /// <summary>Expects a +-1 grid input</summary>
-      void add(const LatticeType& grid);
+      void add(const SpinLattice& grid);
 
       /// <summary>Returns the temporal average over the recorded data in [0,255] range</summary>
       LatticeIType get_average();
@@ -32,7 +32,7 @@ namespace magneto {
    class MovieWriter : public VisualOutput {
    public:
       MovieWriter(const size_t Lx, const size_t Ly, const ImageMode& image_mode, const std::string& temp_string, const int blend_frames = 1);
-      void snapshot(const LatticeType& grid, const bool last_frame = false);
+      void snapshot(const SpinLattice& grid, const bool last_frame = false);
       void end_actions();
       void make_movie() const;
 
@@ -52,7 +52,7 @@ namespace magneto {
    class IntervalWriter : public VisualOutput {
    public:
       IntervalWriter(const size_t Lx, const size_t Ly, const ImageMode& image_mode, const std::string& temp_string);
-      void snapshot(const LatticeType& grid, const bool last_frame = false);
+      void snapshot(const SpinLattice& grid, const bool last_frame = false);
       void end_actions();
 
    private:
@@ -65,7 +65,7 @@ namespace magneto {
    class EndImageWriter : public VisualOutput {
    public:
       EndImageWriter(const size_t Lx, const size_t Ly, const ImageMode& image_mode, const std::string& temp_string);
-      void snapshot(const LatticeType& grid, const bool last_frame = false);
+      void snapshot(const SpinLattice& grid, const bool last_frame = false);
       void end_actions();
 
    private:
@@ -76,7 +76,7 @@ namespace magneto {
    class NullImageWriter : public VisualOutput {
    public:
       NullImageWriter(const size_t Lx, const size_t Ly, const ImageMode& image_mode, const std::string& temp_string);
-      void snapshot(const LatticeType& grid, const bool last_frame = false);
+      void snapshot(const SpinLattice& grid, const bool last_frame = false);
       void end_actions();
 
    private:
@@ -0,0 +1,296 @@
+#include "WangLandau.h"
+#include "CounterRng.h"
+#include "IsingSystem.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+
+namespace {
+
+   /// <summary>Minimal histogram entry relative to the mean for the histogram to count as flat</summary>
+   constexpr double flatness = 0.8;
+   constexpr int sweeps_between_flatness_checks = 10;
+
+
+   /// <summary>Energy levels [first_level, last_level] sampled by one Wang-Landau walker</summary>
+   struct EnergyWindow {
+      int first_level = 0;
+      int last_level = 0;
+      std::vector<char> visited;
+      std::vector<double> log_g;
+      std::vector<double> abs_m_sum;
+      std::vector<double> m2_sum;
+      std::vector<unsigned int> samples;
+   };
+
+
+   /// <summary>Splits the levels into windows of equal width, neighbouring windows overlap by half</summary>
+   std::vector<EnergyWindow> get_windows(const int levels, const int window_count) {
+      const double width = 2.0 * levels / (window_count + 1);
+      std::vector<EnergyWindow> windows(window_count);
+      for (int k = 0; k < window_count; ++k) {
+         EnergyWindow& window = windows[k];
+         window.first_level = static_cast<int>(std::lround(0.5 * k * width));
+         window.last_level = k + 1 == window_count ? levels - 1 : static_cast<int>(std::lround(0.5 * k * width + width)) - 1;
+         const int size = window.last_level - window.first_level + 1;
+         window.visited.resize(size, 0);
+         window.log_g.resize(size, 0.0);
+         window.abs_m_sum.resize(size, 0.0);
+         window.m2_sum.resize(size, 0.0);
+         window.samples.resize(size, 0);
+      }
+      return windows;
+   }
+
+
+   bool is_flat(const std::vector<unsigned int>& histogram, const std::vector<char>& visited) {
+      double sum = 0.0;
+      unsigned int minimum = std::numeric_limits<unsigned int>::max();
+      int count = 0;
+      for (size_t k = 0; k < histogram.size(); ++k) {
+         if (!visited[k])
+            continue;
+         sum += histogram[k];
+         minimum = std::min(minimum, histogram[k]);
+         ++count;
+      }
+      return count > 0 && minimum >= flatness * sum / count;
+   }
+
+
+   /// <summary>Random walk with acceptance min(1, g(E_old)/g(E_new)), restricted to one window</summary>
+   void sample_window(
+      EnergyWindow& window,
+      const int Lx,
+      const int Ly,
+      const double final_log_f,
+      const unsigned int production_sweeps,
+      const magneto::CounterRng& stream
+   ) {
+      const int N = Lx * Ly;
+      const int levels = N + 1;
+      std::mt19937_64 rng(stream.get_seed());
+      std::uniform_int_distribution<int> dist_i(0, Ly - 1);
+      std::uniform_int_distribution<int> dist_j(0, Lx - 1);
+      std::uniform_real_distribution<double> dist_one(0.0, 1.0);
+
+      // Start from the ground state or the checkerboard state, whichever is closer to the window
+      magneto::SpinLattice lattice(Lx, Ly, 1);
+      int level = 0;
+      int M = N;
+      if (window.first_level > levels / 2) {
+         for (int i = 0; i < Ly; ++i)
+            for (int j = 0; j < Lx; ++j)
+               lattice.set(i, j, (i + j) % 2 == 0 ? 1 : -1);
+         level = levels - 1;
+         M = 0;
+      }
+
+      const auto distance_to_window = [&](const int l) {
+         return l < window.first_level ? window.first_level - l : (l > window.last_level ? l - window.last_level : 0);
+      };
+      const auto flip = [&](const int i, const int j, const int new_level) {
+         M -= 2 * lattice(i, j);
+         lattice.set(i, j, -lattice(i, j));
+         level = new_level;
+      };
+
+      // Walk into the window without ever moving away from it
+      while (distance_to_window(level) > 0) {
+         const int i = dist_i(rng);
+         const int j = dist_j(rng);
+         const int new_level = level + magneto::get_dE(lattice, lattice.get_index(i, j)) / 4;
+         if (distance_to_window(new_level) <= distance_to_window(level))
+            flip(i, j, new_level);
+      }
+
+      // One attempted single spin flip, returns the window index of the resulting state
+      const auto step = [&]() {
+         const int i = dist_i(rng);
+         const int j = dist_j(rng);
+         const int new_level = level + magneto::get_dE(lattice, lattice.get_index(i, j)) / 4;
+         if (distance_to_window(new_level) == 0) {
+            const double log_ratio = window.log_g[level - window.first_level] - window.log_g[new_level - window.first_level];
+            if (log_ratio >= 0.0 || dist_one(rng) < exp(log_ratio))
+               flip(i, j, new_level);
+         }
+         return level - window.first_level;
+      };
+
+      std::vector<unsigned int> histogram(window.log_g.size(), 0);
+      unsigned long long sweeps = 0;
+      for (double log_f = 1.0; log_f >= final_log_f; ) {
+         for (int sweep = 0; sweep < sweeps_between_flatness_checks; ++sweep) {
+            for (int attempt = 0; attempt < N; ++attempt) {
+               const int k = step();
+               window.log_g[k] += log_f;
+               window.visited[k] = 1;
+               ++histogram[k];
+            }
+         }
+         sweeps += sweeps_between_flatness_checks;
+         if (is_flat(histogram, window.visited)) {
+            log_f /= 2.0;
+            std::fill(histogram.begin(), histogram.end(), 0);
+         }
+      }
+      magneto::get_logger()->info(
+         "Wang-Landau window E/N=[{:.3f}, {:.3f}] converged after {} sweeps",
+         -2.0 + 4.0 * window.first_level / N, -2.0 + 4.0 * window.last_level / N, sweeps
+      );
+
+      // Production with fixed g(E): flat in energy, so every level gets magnetization samples
+      for (unsigned int sweep = 0; sweep < production_sweeps; ++sweep) {
+         for (int attempt = 0; attempt < N; ++attempt) {
+            const int k = step();
+            const double m = static_cast<double>(M) / N;
+            window.abs_m_sum[k] += std::abs(m);
+            window.m2_sum[k] += m * m;
+            ++window.samples[k];
+         }
+      }
+   }
+
+
+   /// <summary>Joins the ln(g) of all windows. Every window is shifted to match the previous one on
+   /// average in their common levels, the join itself is in the middle of the overlap.</summary>
+   std::optional<magneto::DensityOfStates> join_windows(const std::vector<EnergyWindow>& windows, const int Lx, const int Ly) {
+      const int levels = Lx * Ly + 1;
+      magneto::DensityOfStates dos;
+      dos.Lx = Lx;
+      dos.Ly = Ly;
+      dos.visited.resize(levels, 0);
+      dos.log_g.resize(levels, 0.0);
+
+      double previous_shift = 0.0;
+      for (size_t w = 0; w < windows.size(); ++w) {
+         const EnergyWindow& window = windows[w];
+         double shift = 0.0;
+         int first_taken = window.first_level;
+         if (w > 0) {
+            const EnergyWindow& previous = windows[w - 1];
+            double difference_sum = 0.0;
+            int common = 0;
+            for (int l = window.first_level; l <= previous.last_level; ++l) {
+               if (!window.visited[l - window.first_level] || !previous.visited[l - previous.first_level])
+                  continue;
+               difference_sum += previous.log_g[l - previous.first_level] + previous_shift - window.log_g[l - window.first_level];
+               ++common;
+            }
+            if (common == 0) {
+               magneto::get_logger()->error("Wang-Landau windows {} and {} have no common energy levels.", w - 1, w);
+               return std::nullopt;
+            }
+            shift = difference_sum / common;
+            first_taken = (window.first_level + previous.last_level) / 2;
+         }
+         for (int l = first_taken; l <= window.last_level; ++l) {
+            dos.visited[l] = window.visited[l - window.first_level];
+            dos.log_g[l] = window.log_g[l - window.first_level] + shift;
+         }
+         previous_shift = shift;
+      }
+
+      // The two fully aligned states
+      const double normalization = log(2.0) - dos.log_g[0];
+      for (double& log_g : dos.log_g)
+         log_g += normalization;
+
+      // Microcanonical averages don't depend on the sampling weights, so all windows are pooled
+      std::vector<double> abs_m_sum(levels, 0.0);
+      std::vector<double> m2_sum(levels, 0.0);
+      std::vector<unsigned int> samples(levels, 0);
+      for (const EnergyWindow& window : windows) {
+         for (size_t k = 0; k < window.samples.size(); ++k) {
+            abs_m_sum[window.first_level + k] += window.abs_m_sum[k];
+            m2_sum[window.first_level + k] += window.m2_sum[k];
+            samples[window.first_level + k] += window.samples[k];
+         }
+      }
+      dos.mean_abs_m.resize(levels, -1.0);
+      dos.mean_m2.resize(levels, -1.0);
+      for (int l = 0; l < levels; ++l) {
+         if (samples[l] == 0)
+            continue;
+         dos.mean_abs_m[l] = abs_m_sum[l] / samples[l];
+         dos.mean_m2[l] = m2_sum[l] / samples[l];
+      }
+      return dos;
+   }
+
+} // namespace {}
+
+
+std::optional<magneto::DensityOfStates> magneto::get_density_of_states(
+   const unsigned int Lx,
+   const unsigned int Ly,
+   const unsigned int windows,
+   const double final_log_f,
+   const unsigned int production_sweeps,
+   const uint64_t seed,
+   TaskScheduler& scheduler
+) {
+   const int levels = static_cast<int>(Lx * Ly) + 1;
+   const int window_count = std::clamp(static_cast<int>(windows), 1, levels / 4);
+   std::vector<EnergyWindow> energy_windows = get_windows(levels, window_count);
+
+   get_logger()->info("Starting Wang-Landau sampling for {}X{} System with {} windows", Lx, Ly, window_count);
+   std::vector<Task> tasks;
+   for (size_t w = 0; w < energy_windows.size(); ++w) {
+      tasks.push_back({ static_cast<double>(energy_windows[w].log_g.size()), [&, w] {
+         sample_window(energy_windows[w], Lx, Ly, final_log_f, production_sweeps, CounterRng(seed, static_cast<uint32_t>(w)));
+      } });
+   }
+   scheduler.run(std::move(tasks));
+   return join_windows(energy_windows, Lx, Ly);
+}
+
+
+std::vector<magneto::PhysicsResult> magneto::get_physical_results(
+   const DensityOfStates& dos, const int J, const std::vector<double>& temps
+) {
+   const int N = dos.Lx * dos.Ly;
+   const int levels = N + 1;
+   std::vector<PhysicsResult> results;
+   for (const double T : temps) {
+      // Boltzmann weights in log space, shifted by their maximum to avoid overflow
+      std::vector<double> log_weights(levels, 0.0);
+      double max_log_weight = -std::numeric_limits<double>::infinity();
+      for (int l = 0; l < levels; ++l) {
+         if (!dos.visited[l])
+            continue;
+         const double E = -2.0 * N + 4.0 * l;
+         log_weights[l] = dos.log_g[l] - J * E / T;
+         max_log_weight = std::max(max_log_weight, log_weights[l]);
+      }
+
+      double Z = 0.0, e_sum = 0.0, e2_sum = 0.0;
+      double Z_m = 0.0, abs_m_sum = 0.0, m2_sum = 0.0;
+      for (int l = 0; l < levels; ++l) {
+         if (!dos.visited[l])
+            continue;
+         const double weight = exp(log_weights[l] - max_log_weight);
+         const double e = -2.0 + 4.0 * l / N;
+         Z += weight;
+         e_sum += weight * e;
+         e2_sum += weight * e * e;
+         if (dos.mean_abs_m[l] < 0.0)
+            continue;
+         Z_m += weight;
+         abs_m_sum += weight * dos.mean_abs_m[l];
+         m2_sum += weight * dos.mean_m2[l];
+      }
+
+      const double mean_energy = e_sum / Z;
+      const double mean_magnetization = Z_m > 0.0 ? abs_m_sum / Z_m : 0.0;
+      const double mean_m2 = Z_m > 0.0 ? m2_sum / Z_m : 0.0;
+      const double cv = (e2_sum / Z - mean_energy * mean_energy) * N / (T * T);
+      const double chi = (mean_m2 - mean_magnetization * mean_magnetization) * N / T;
+      results.push_back({ T, mean_energy, cv, mean_magnetization, chi });
+   }
+   return results;
+}
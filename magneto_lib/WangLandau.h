@@ -0,0 +1,45 @@
+#pragma once
+
+#include "physics_tools.h"
+#include "TaskScheduler.h"
+
+#include <optional>
+
+
+namespace magneto {
+
+   /// <summary>Density of states and microcanonical magnetizations of a lattice
+   /// <para>Entry k belongs to the energy level E = -2N + 4k (in units of |J|, N = Lx*Ly). Levels that
+   /// were never visited have no entry in visited and are ignored.</para>
+   /// </summary>
+   struct DensityOfStates {
+      unsigned int Lx = 0;
+      unsigned int Ly = 0;
+      std::vector<char> visited;
+      std::vector<double> log_g;
+      std::vector<double> mean_abs_m;
+      std::vector<double> mean_m2;
+   };
+
+
+   /// <summary>Estimates g(E) with Wang-Landau sampling, split into overlapping energy windows
+   /// <para>The windows are sampled as parallel tasks and independently until the histogram of each is flat
+   /// and ln(f) fell below final_log_f. Adjacent windows are then joined by matching ln(g) in their
+   /// overlap and normalized to the two ground states. Afterwards every window runs
+   /// production_sweeps sweeps with the fixed g(E) to record |m| and m^2 per energy level. Every
+   /// window draws from its own stream of the seed.
+   /// Requires even Lx and Ly so that the whole energy range is reachable.</para>
+   /// </summary>
+   std::optional<DensityOfStates> get_density_of_states(
+      const unsigned int Lx,
+      const unsigned int Ly,
+      const unsigned int windows,
+      const double final_log_f,
+      const unsigned int production_sweeps,
+      const uint64_t seed,
+      TaskScheduler& scheduler
+   );
+
+   /// <summary>Canonical averages at every temperature, derived from the density of states</summary>
+   std::vector<PhysicsResult> get_physical_results(const DensityOfStates& dos, const int J, const std::vector<double>& temps);
+}
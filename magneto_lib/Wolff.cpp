@@ -0,0 +1,141 @@
+#include "Wolff.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+   /// <summary>Grows the cluster around a random seed site and flips it, returns its size
+   /// <para>freeze_probability(site) is used like in swendsen_wang_step: a bond belongs to the site
+   /// on its left or upper end, including across the periodic wrap.</para>
+   /// <para>The stack doubles as the member list of the cluster: entries from next on are still to be
+   /// expanded, all pushed sites are flipped at the end. Only bonds to sites outside the cluster
+   /// change their energy, they are added to totals together with the magnetization.</para>
+   /// </summary>
+   template<class TFreezeProbability>
+   int flip_cluster(
+      magneto::SpinLattice& lattice,
+      std::vector<int>& stack,
+      std::vector<unsigned int>& visited,
+      unsigned int& generation,
+      std::mt19937_64& rng,
+      const TFreezeProbability& freeze_probability,
+      magneto::LatticeTotals& totals
+   ) {
+      const int Lx = lattice.get_Lx();
+      const int Ly = lattice.get_Ly();
+      std::uniform_int_distribution<int> dist_site(0, Lx * Ly - 1);
+      std::uniform_real_distribution<double> dist_one(0.0, 1.0);
+
+      ++generation;
+      if (generation == 0) {
+         // Wrapped around, old marks could be mistaken for the current generation
+         std::fill(visited.begin(), visited.end(), 0);
+         generation = 1;
+      }
+
+      const int seed = dist_site(rng);
+      const char cluster_spin = lattice[lattice.get_index(seed / Lx, seed % Lx)];
+      visited[seed] = generation;
+      stack[0] = seed;
+      int size = 1;
+      int next = 0;
+
+      const auto try_add = [&](const int bond_owner, const int neighbour, const int neighbour_i, const int neighbour_j) {
+         if (visited[neighbour] == generation || lattice[lattice.get_index(neighbour_i, neighbour_j)] != cluster_spin)
+            return;
+         if (dist_one(rng) < freeze_probability(bond_owner)) {
+            visited[neighbour] = generation;
+            stack[size++] = neighbour;
+         }
+      };
+
+      const auto for_each_neighbour = [&](const int site, const auto& f) {
+         const int i = site / Lx;
+         const int j = site % Lx;
+         const int right_j = j + 1 == Lx ? 0 : j + 1;
+         const int left_j = j == 0 ? Lx - 1 : j - 1;
+         const int down_i = i + 1 == Ly ? 0 : i + 1;
+         const int up_i = i == 0 ? Ly - 1 : i - 1;
+         f(site, i * Lx + right_j, i, right_j);
+         f(i * Lx + left_j, i * Lx + left_j, i, left_j);
+         f(site, down_i * Lx + j, down_i, j);
+         f(up_i * Lx + j, up_i * Lx + j, up_i, j);
+      };
+
+      while (next < size)
+         for_each_neighbour(stack[next++], try_add);
+
+      int energy_change = 0;
+      for (int k = 0; k < size; ++k) {
+         for_each_neighbour(stack[k], [&](const int /*bond_owner*/, const int neighbour, const int neighbour_i, const int neighbour_j) {
+            if (visited[neighbour] != generation)
+               energy_change += 2 * cluster_spin * lattice[lattice.get_index(neighbour_i, neighbour_j)];
+         });
+      }
+      for (int k = 0; k < size; ++k)
+         lattice.set(stack[k] / Lx, stack[k] % Lx, -cluster_spin);
+      totals.energy += energy_change;
+      totals.magnetization -= 2 * cluster_spin * size;
+      return size;
+   }
+
+} // namespace {}
+
+
+magneto::Wolff::Wolff(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng)
+   : m_stack(Lx * Ly)
+   , m_visited(Lx * Ly, 0)
+   , m_rng(rng.get_seed())
+   , m_freeze_probability(get_freeze_probability(J, T))
+   , m_J(J)
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::Wolff::set_temperature(const double T) {
+   m_freeze_probability = get_freeze_probability(m_J, T);
+   return true;
+}
+
+
+void magneto::Wolff::run(SpinLattice& lattice) {
+   const int site_count = lattice.get_Lx() * lattice.get_Ly();
+   const auto freeze_probability = [&](const int /*site*/) {return m_freeze_probability; };
+   LatticeTotals change;
+   int flipped = 0;
+   while (flipped < site_count)
+      flipped += flip_cluster(lattice, m_stack, m_visited, m_generation, m_rng, freeze_probability, change);
+   add_to_totals(change);
+}
+
+
+magneto::VariableWolff::VariableWolff(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng)
+   : m_stack(Lx * Ly)
+   , m_visited(Lx * Ly, 0)
+   , m_rng(rng.get_seed())
+   , m_freeze_probability(get_freeze_probability(Lx, Ly, J, T))
+   , m_J(J)
+{
+   set_tracks_totals();
+}
+
+
+bool magneto::VariableWolff::set_temperature_field(const LatticeDType& T) {
+   const auto [Lx, Ly] = get_dimensions_of_lattice(T);
+   m_freeze_probability = get_freeze_probability(Lx, Ly, m_J, T);
+   return true;
+}
+
+
+void magneto::VariableWolff::run(SpinLattice& lattice) {
+   const int site_count = lattice.get_Lx() * lattice.get_Ly();
+   const auto freeze_probability = [&](const int site) {return m_freeze_probability[site]; };
+   LatticeTotals change;
+   int flipped = 0;
+   while (flipped < site_count)
+      flipped += flip_cluster(lattice, m_stack, m_visited, m_generation, m_rng, freeze_probability, change);
+   add_to_totals(change);
+}
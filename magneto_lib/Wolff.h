@@ -0,0 +1,47 @@
+#pragma once
+
+#include "LatticeAlgorithms.h"
+
+#include <random>
+
+
+namespace magneto {
+
+   /// <summary>Wolff single-cluster algorithm
+   /// <para>Grows one cluster from a random seed site, adding equal neighbours with the SW freeze
+   /// probability, and flips it. One run() flips clusters until at least Lx*Ly spins were flipped,
+   /// so a run is comparable to one sweep of the other algorithms.</para>
+   /// <para>The cluster stack is preallocated. Visited sites are marked with the current cluster
+   /// generation, so the marks never need to be cleared between clusters.</para>
+   /// </summary>
+   class Wolff : public LatticeAlgorithm {
+   public:
+      Wolff(const int J, const double T, const int Lx, const int Ly, const CounterRng& rng);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature(const double T);
+
+   private:
+      std::vector<int> m_stack;
+      std::vector<unsigned int> m_visited;
+      unsigned int m_generation = 0;
+      std::mt19937_64 m_rng;
+      double m_freeze_probability;
+      int m_J;
+   };
+
+
+   class VariableWolff : public LatticeAlgorithm {
+   public:
+      VariableWolff(const int J, const LatticeDType& T, const int Lx, const int Ly, const CounterRng& rng);
+      virtual void run(SpinLattice& lattice);
+      virtual bool set_temperature_field(const LatticeDType& T);
+
+   private:
+      std::vector<int> m_stack;
+      std::vector<unsigned int> m_visited;
+      unsigned int m_generation = 0;
+      std::mt19937_64 m_rng;
+      std::vector<double> m_freeze_probability;
+      int m_J;
+   };
+}
@@ -0,0 +1,140 @@
+#include "cpu_tools.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <windows.h>
+#else
+#include <cpuid.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace {
+
+   struct CpuidResult {
+      uint32_t eax = 0;
+      uint32_t ebx = 0;
+      uint32_t ecx = 0;
+      uint32_t edx = 0;
+   };
+
+
+   CpuidResult get_cpuid(const uint32_t leaf, const uint32_t subleaf) {
+      CpuidResult result;
+#ifdef _MSC_VER
+      int registers[4];
+      __cpuidex(registers, static_cast<int>(leaf), static_cast<int>(subleaf));
+      result = { static_cast<uint32_t>(registers[0]), static_cast<uint32_t>(registers[1]), static_cast<uint32_t>(registers[2]), static_cast<uint32_t>(registers[3]) };
+#else
+      __cpuid_count(leaf, subleaf, result.eax, result.ebx, result.ecx, result.edx);
+#endif
+      return result;
+   }
+
+
+   /// <summary>Register state the OS saves on context switches (XCR0)</summary>
+   uint64_t get_xcr0() {
+#ifdef _MSC_VER
+      return _xgetbv(0);
+#else
+      uint32_t eax, edx;
+      __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+      return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+   }
+
+
+   magneto::SimdLevel detect_simd_level() {
+      const CpuidResult leaf1 = get_cpuid(1, 0);
+      const bool has_osxsave = (leaf1.ecx >> 27) & 1;
+      if (!has_osxsave)
+         return magneto::SimdLevel::SSE2;
+
+      // The instruction set alone isn't enough, the OS also has to save the wider registers
+      const uint64_t xcr0 = get_xcr0();
+      const bool os_saves_ymm = (xcr0 & 0x6) == 0x6;
+      const bool os_saves_zmm = (xcr0 & 0xe6) == 0xe6;
+
+      const CpuidResult leaf7 = get_cpuid(7, 0);
+      const bool has_avx2 = (leaf7.ebx >> 5) & 1;
+      const bool has_avx512f = (leaf7.ebx >> 16) & 1;
+      const bool has_avx512bw = (leaf7.ebx >> 30) & 1;
+
+      if (os_saves_zmm && has_avx512f && has_avx512bw)
+         return magneto::SimdLevel::AVX512;
+      if (os_saves_ymm && has_avx2)
+         return magneto::SimdLevel::AVX2;
+      return magneto::SimdLevel::SSE2;
+   }
+
+} // namespace {}
+
+
+magneto::SimdLevel magneto::get_simd_level() {
+   static const SimdLevel level = [] {
+      const SimdLevel detected = detect_simd_level();
+      get_logger()->info("Detected SIMD support: {}", get_simd_level_name(detected));
+      return detected;
+   }();
+   return level;
+}
+
+
+std::string magneto::get_simd_level_name(const SimdLevel level) {
+   if (level == SimdLevel::AVX512)
+      return "AVX-512";
+   else if (level == SimdLevel::AVX2)
+      return "AVX2";
+   else
+      return "SSE2";
+}
+
+
+std::vector<unsigned int> magneto::get_usable_cores() {
+   std::vector<unsigned int> cores;
+#ifdef _MSC_VER
+   // Only the processor group of the process, so at most 64 cores
+   DWORD_PTR process_mask = 0, system_mask = 0;
+   if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+      for (unsigned int core = 0; core < 8 * sizeof(DWORD_PTR); ++core)
+         if ((process_mask >> core) & 1)
+            cores.emplace_back(core);
+   }
+#else
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (unsigned int core = 0; core < CPU_SETSIZE; ++core)
+         if (CPU_ISSET(core, &set))
+            cores.emplace_back(core);
+   }
+#endif
+   if (cores.empty()) {
+      for (unsigned int core = 0; core < std::max(1u, std::thread::hardware_concurrency()); ++core)
+         cores.emplace_back(core);
+   }
+   return cores;
+}
+
+
+bool magneto::pin_current_thread(const unsigned int first_core, const unsigned int core_count) {
+   static const std::vector<unsigned int> usable_cores = get_usable_cores();
+   const unsigned int count = std::clamp(core_count, 1u, static_cast<unsigned int>(usable_cores.size()));
+#ifdef _MSC_VER
+   DWORD_PTR mask = 0;
+   for (unsigned int k = 0; k < count; ++k)
+      mask |= static_cast<DWORD_PTR>(1) << usable_cores[(first_core + k) % usable_cores.size()];
+   return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   for (unsigned int k = 0; k < count; ++k)
+      CPU_SET(usable_cores[(first_core + k) % usable_cores.size()], &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
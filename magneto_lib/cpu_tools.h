@@ -0,0 +1,23 @@
+#pragma once
+
+#include "export_macro.h"
+
+#include <string>
+#include <vector>
+
+
+namespace magneto {
+   enum class SimdLevel { SSE2, AVX2, AVX512 };
+
+   /// <summary>Returns the widest instruction set usable on this CPU (and OS). Detected once.</summary>
+   CLASS_DECLSPEC SimdLevel get_simd_level();
+
+   std::string get_simd_level_name(const SimdLevel level);
+
+   /// <summary>Logical processors this process may run on, in ascending order</summary>
+   std::vector<unsigned int> get_usable_cores();
+
+   /// <summary>Restricts the calling thread to core_count consecutive usable cores, starting at the
+   /// given position in get_usable_cores(). Positions wrap around. Returns false if the OS refused.</summary>
+   bool pin_current_thread(const unsigned int first_core, const unsigned int core_count);
+}
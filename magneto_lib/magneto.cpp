@@ -6,11 +6,26 @@
 #include "ProgressIndicator.h"
 #include "windows.h"
 #include "LatticeAlgorithms.h"
+#include "MultiSpinMetropolis.h"
+#include "CheckerboardMetropolis.h"
+#include "SimdMetropolis.h"
+#include "ParallelSW.h"
+#include "Wolff.h"
+#include "ReplicaExchange.h"
+#include "WangLandau.h"
+#include "Reweighting.h"
+#include "RngPool.h"
+#include "TaskScheduler.h"
+#include "ThreadPlan.h"
 #include "file_tools.h"
 #include "physics_tools.h"
 #include "logging.h"
 
-#include <execution>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <sstream>
 
 
@@ -61,13 +76,30 @@ std::unique_ptr<magneto::LatticeAlgorithm> get_lattice_algorithm(
    const magneto::LatticeDType& lattice_temps,
    const int Lx,
    const int Ly,
-   const int J
+   const int J,
+   const magneto::CounterRng& rng,
+   const int algorithm_threads = 0,
+   const magneto::Acceptance acceptance = magneto::Acceptance::Integer,
+   const magneto::RandomMode random_mode = magneto::RandomMode::Buffered
 ) {
-   if (alg == magneto::Algorithm::Metropolis) {
-         return std::make_unique<magneto::VariableMetropolis>(J, lattice_temps, Lx, Ly);
+   // Multi-spin coding and the SIMD kernel need one acceptance probability for all spins
+   if (alg == magneto::Algorithm::Metropolis || alg == magneto::Algorithm::MultiSpinMetropolis || alg == magneto::Algorithm::SimdMetropolis) {
+         return std::make_unique<magneto::VariableMetropolis>(J, lattice_temps, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::CheckerboardMetropolis) {
+      if (magneto::is_checkerboard_compatible(Lx, Ly))
+         return std::make_unique<magneto::VariableCheckerboardMetropolis>(J, lattice_temps, Lx, Ly, rng, algorithm_threads);
+      magneto::get_logger()->warn("Parallel Metropolis needs even Lx and Ly, using regular Metropolis instead.");
+      return std::make_unique<magneto::VariableMetropolis>(J, lattice_temps, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::ParallelSW) {
+      return std::make_unique<magneto::VariableParallelSW>(J, lattice_temps, Lx, Ly, rng, algorithm_threads);
+   }
+   else if (alg == magneto::Algorithm::Wolff) {
+      return std::make_unique<magneto::VariableWolff>(J, lattice_temps, Lx, Ly, rng);
    }
    else {
-      return std::make_unique<magneto::VariableSW>(J, lattice_temps, Lx, Ly);
+      return std::make_unique<magneto::VariableSW>(J, lattice_temps, Lx, Ly, rng, acceptance, random_mode);
    }
 }
 
@@ -77,24 +109,93 @@ std::unique_ptr<magneto::LatticeAlgorithm> get_lattice_algorithm(
    const double T,
    const int Lx,
    const int Ly,
-   const int J
+   const int J,
+   const magneto::CounterRng& rng,
+   const int algorithm_threads = 0,
+   const magneto::Acceptance acceptance = magneto::Acceptance::Integer,
+   const magneto::RandomMode random_mode = magneto::RandomMode::Buffered
 ) {
    if (alg == magneto::Algorithm::Metropolis) {
-      return std::make_unique<magneto::Metropolis>(J, T, Lx, Ly);
+      return std::make_unique<magneto::Metropolis>(J, T, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::CheckerboardMetropolis) {
+      if (magneto::is_checkerboard_compatible(Lx, Ly))
+         return std::make_unique<magneto::CheckerboardMetropolis>(J, T, Lx, Ly, rng, algorithm_threads);
+      magneto::get_logger()->warn("Parallel Metropolis needs even Lx and Ly, using regular Metropolis instead.");
+      return std::make_unique<magneto::Metropolis>(J, T, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::SimdMetropolis) {
+      if (magneto::is_checkerboard_compatible(Lx, Ly))
+         return std::make_unique<magneto::SimdMetropolis>(J, T, Lx, Ly, rng);
+      magneto::get_logger()->warn("SIMD Metropolis needs even Lx and Ly, using regular Metropolis instead.");
+      return std::make_unique<magneto::Metropolis>(J, T, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::MultiSpinMetropolis) {
+      if (magneto::is_checkerboard_compatible(Lx, Ly))
+         return std::make_unique<magneto::MultiSpinMetropolis>(J, T, Lx, Ly, rng);
+      magneto::get_logger()->warn("Multi-spin Metropolis needs even Lx and Ly, using regular Metropolis instead.");
+      return std::make_unique<magneto::Metropolis>(J, T, Lx, Ly, rng, acceptance);
+   }
+   else if (alg == magneto::Algorithm::ParallelSW) {
+      return std::make_unique<magneto::ParallelSW>(J, T, Lx, Ly, rng, algorithm_threads);
+   }
+   else if (alg == magneto::Algorithm::Wolff) {
+      return std::make_unique<magneto::Wolff>(J, T, Lx, Ly, rng);
    }
    else {
-      return std::make_unique<magneto::SW>(J, T, Lx, Ly);
+      return std::make_unique<magneto::SW>(J, T, Lx, Ly, rng, acceptance, random_mode);
    }
 }
 
 
+/// <summary>Iterations before the first equilibration check, later checks are at twice the length</summary>
+constexpr unsigned int first_equilibration_check = 100;
+
+
+/// <summary>Runs before the measurements, with the algorithm of the job and its own random numbers
+/// <para>With automatic equilibration, the series of energy and absolute magnetization are checked
+/// at doubling lengths and the warmup ends once both MSER truncation points are in the first half.
+/// The magnetization catches the slow coarsening of domains after the energy has mostly relaxed.
+/// start_runs is the limit.</para>
+/// </summary>
 template<class TTemp>
-void warmup_system(magneto::IsingSystem& system, const TTemp& T, const unsigned int runs) {
-   const auto [Lx, Ly] = magneto::get_dimensions_of_lattice(system.get_lattice());
-   auto alg = get_lattice_algorithm(magneto::Algorithm::SW, T, Lx, Ly, system.get_J());
-   for (unsigned int i = 1; i < runs; ++i) {
+void warmup_system(
+   magneto::IsingSystem& system,
+   const TTemp& T,
+   const magneto::Job& job,
+   const uint32_t temperature_index,
+   const magneto::Equilibration equilibration
+) {
+   const magneto::CounterRng rng(job.m_seed, temperature_index, magneto::RngPhase::Warmup);
+   auto alg = get_lattice_algorithm(job.m_algorithm, T, job.m_Lx, job.m_Ly, job.m_J, rng, job.m_algorithm_threads, job.m_acceptance, job.m_random_mode);
+   if (equilibration == magneto::Equilibration::Fixed || job.m_start_runs == 0) {
+      for (unsigned int i = 1; i < job.m_start_runs; ++i) {
+         alg->run(system.get_lattice_nc());
+      }
+      alg->write_back(system.get_lattice_nc());
+      return;
+   }
+
+   std::vector<double> energies;
+   std::vector<double> magnetizations;
+   size_t next_check = first_equilibration_check;
+   bool is_equilibrated = false;
+   while (energies.size() < job.m_start_runs && !is_equilibrated) {
+      const magneto::LatticeTotals totals = alg->get_totals(system.get_lattice_nc());
+      energies.emplace_back(totals.energy);
+      magnetizations.emplace_back(std::abs(totals.magnetization));
       alg->run(system.get_lattice_nc());
+      if (energies.size() < next_check && energies.size() < job.m_start_runs)
+         continue;
+      const size_t truncation = std::max(magneto::get_mser_truncation(energies), magneto::get_mser_truncation(magnetizations));
+      is_equilibrated = truncation <= energies.size() / 2;
+      if (is_equilibrated)
+         magneto::get_logger()->info("T={}: equilibrated after {} runs, warmup ended after {}", get_temperature_string(T), truncation, energies.size());
+      next_check *= 2;
    }
+   if (!is_equilibrated)
+      magneto::get_logger()->warn("T={}: no equilibration detected within {} start runs", get_temperature_string(T), job.m_start_runs);
+   alg->write_back(system.get_lattice_nc());
 }
 
 
@@ -107,35 +208,259 @@ double get_t_representation_for_measurements(const magneto::LatticeDType& /*t*/)
 }
 
 
+/// <summary>Sweeps between two checks of the target error</summary>
+constexpr unsigned int target_error_check_interval = 250;
+
+/// <summary>Below this many measurements, the blocking analysis has too few levels to be trusted</summary>
+constexpr uint64_t min_measurements_for_target_error = 1000;
+
+
+/// <summary>Measurements at the start of the main iterations that tau_int is estimated from</summary>
+constexpr size_t autocorrelation_window = 1000;
+
+
+/// <summary>Larger relative error of the mean energy and magnetization</summary>
+double get_relative_error(const magneto::MeasurementStatistics& statistics) {
+   const auto relative = [](const double error, const double mean) {
+      return mean != 0.0 ? std::abs(error / mean) : (error > 0.0 ? std::numeric_limits<double>::infinity() : 0.0);
+   };
+   return std::max(
+      relative(statistics.m_energy_blocking.get_error(), statistics.m_energy.get_mean()),
+      relative(statistics.m_magnetization_blocking.get_error(), statistics.m_magnetization.get_mean())
+   );
+}
+
+
+/// <summary>Critical temperature of the square lattice in units of |J|</summary>
+constexpr double critical_temperature = 2.269185314213022;
+
+
+/// <summary>Rough run time of one temperature, only compared with the other temperatures of the job
+/// <para>Sites times runs. The correlation time follows the correlation length, capped at the
+/// lattice size, to the power of the dynamic exponent: about 2.17 for local updates and 0.25 for
+/// cluster updates. It scales the runs that adapt to it: the automatic warmup and the sweeps to a
+/// target error, which thinning multiplies. Below Tc, local updates also have to
+/// coarsen domains to the lattice size before they equilibrate.</para>
+/// </summary>
+double get_expected_cost(const magneto::Job& job, const double T) {
+   const double sites = static_cast<double>(job.m_Lx) * job.m_Ly;
+   const double L = std::sqrt(sites);
+   const double reduced_distance = std::max(std::abs(1.0 - T / critical_temperature), 1.0 / L);
+   const double correlation_length = std::min(L, 1.0 / reduced_distance);
+   const bool is_cluster = job.m_algorithm == magneto::Algorithm::SW
+      || job.m_algorithm == magneto::Algorithm::ParallelSW
+      || job.m_algorithm == magneto::Algorithm::Wolff;
+   const double tau = std::pow(correlation_length, is_cluster ? 0.25 : 2.17);
+
+   double warmup_runs = job.m_start_runs;
+   if (job.m_equilibration == magneto::Equilibration::Automatic) {
+      const double relaxation = !is_cluster && T < critical_temperature ? std::max(tau, sites) : tau;
+      warmup_runs = std::min(warmup_runs, first_equilibration_check * relaxation);
+   }
+   double main_runs = job.m_n;
+   if (job.m_target_rel_error > 0.0) {
+      const double runs_per_measurement = job.m_thinning == magneto::Thinning::Automatic ? std::ceil(2.0 * tau) : 1.0;
+      main_runs = std::min<double>(job.m_max_iterations, min_measurements_for_target_error * tau * runs_per_measurement);
+   }
+   return sites * (warmup_runs + main_runs);
+}
+
+
+/// <summary>The system at one temperature together with its algorithm, output and measurements</summary>
+template<class TTemp>
+struct Replica {
+   Replica(const TTemp& T, const magneto::Job& job, const uint32_t temperature_index)
+      : m_T(T)
+      , m_job(job)
+      , m_rng(job.m_seed, temperature_index)
+      , m_temp_string(get_temperature_string(T))
+      , m_visual_output(get_visual_output(job.m_image_mode.m_mode, job.m_Lx, job.m_Ly, job.m_image_mode, m_temp_string))
+      , m_algorithm(get_lattice_algorithm(job.m_algorithm, T, job.m_Lx, job.m_Ly, job.m_J, m_rng, job.m_algorithm_threads, job.m_acceptance, job.m_random_mode))
+      , m_system(job.m_J, job.initial_spins)
+   {
+      magneto::get_logger()->info("Starting computations for {}X{} System, T={}", job.m_Lx, job.m_Ly, m_temp_string);
+   }
+
+   /// <summary>Propagates the system for the given number of main sweeps and records it before
+   /// every m_measurement_interval-th of them. The measurements come from the totals the algorithm
+   /// keeps and go into the running statistics.
+   /// <para>The first measurements are also buffered for tau_int. With automatic thinning, the
+   /// algorithm runs about 2 tau_int times between the measurements after that. The phase carries
+   /// over between calls, so the spacing doesn't depend on how the sweeps are split up.</para>
+   /// </summary>
+   void iterate(const unsigned int sweeps) {
+      for (unsigned int i = 0; i < sweeps; ++i) {
+         if (m_sweeps_to_measurement == 0) {
+            measure();
+            m_sweeps_to_measurement = m_measurement_interval;
+         }
+         m_algorithm->run(m_system.get_lattice_nc());
+         --m_sweeps_to_measurement;
+         ++m_sweeps;
+      }
+   }
+
+   void measure() {
+      const int site_count = m_job.m_Lx * m_job.m_Ly;
+      const magneto::PhysicalMeasurement measurement = get_properties(m_algorithm->get_totals(m_system.get_lattice_nc()), site_count);
+      m_visual_output->snapshot(m_system.get_lattice());
+      m_statistics.add(measurement.energy, measurement.magnetization);
+      if (m_job.m_keep_time_series)
+         m_measurements.emplace_back(measurement);
+      if (m_tau_int == 0.0) {
+         m_autocorrelation_window.emplace_back(measurement);
+         if (m_autocorrelation_window.size() == autocorrelation_window)
+            set_autocorrelation_time();
+      }
+   }
+
+   /// <summary>Estimates tau_int from the buffered measurements and adapts the measurement interval</summary>
+   void set_autocorrelation_time() {
+      std::vector<double> energies, magnetizations;
+      for (const magneto::PhysicalMeasurement& measurement : m_autocorrelation_window) {
+         energies.emplace_back(measurement.energy);
+         magnetizations.emplace_back(measurement.magnetization);
+      }
+      m_autocorrelation_window = {};
+      m_tau_int = std::max(
+         magneto::get_integrated_autocorrelation_time(energies),
+         magneto::get_integrated_autocorrelation_time(magnetizations)
+      );
+      if (m_job.m_thinning == magneto::Thinning::None) {
+         magneto::get_logger()->info("T={}: tau_int={:.2f}", m_temp_string, m_tau_int);
+         return;
+      }
+      m_measurement_interval = static_cast<unsigned int>(std::ceil(2.0 * m_tau_int));
+      magneto::get_logger()->info("T={}: tau_int={:.2f}, measuring every {} runs", m_temp_string, m_tau_int, m_measurement_interval);
+   }
+
+   /// <summary>All main sweeps of the job: up to the target error if there is one, otherwise n</summary>
+   void iterate_main() {
+      if (m_job.m_target_rel_error > 0.0)
+         iterate_to_target_error();
+      else if (m_job.m_n > 1)
+         iterate(m_job.m_n - 1);
+   }
+
+   /// <summary>Iterates until the target error of the job or its sweep limit is reached</summary>
+   void iterate_to_target_error() {
+      while (m_sweeps < m_job.m_max_iterations && !has_reached_target_error()) {
+         const uint64_t remaining = m_job.m_max_iterations - m_sweeps;
+         iterate(static_cast<unsigned int>(std::min<uint64_t>(target_error_check_interval, remaining)));
+      }
+      log_iterations();
+   }
+
+   [[nodiscard]] bool has_reached_target_error() const {
+      return m_statistics.m_energy.get_count() >= min_measurements_for_target_error
+         && get_relative_error(m_statistics) <= m_job.m_target_rel_error;
+   }
+
+   void log_iterations() const {
+      const double relative_error = get_relative_error(m_statistics);
+      if (relative_error <= m_job.m_target_rel_error)
+         magneto::get_logger()->info("T={}: relative error {:.2e} after {} sweeps", m_temp_string, relative_error, m_sweeps);
+      else
+         magneto::get_logger()->warn("T={}: relative error {:.2e} still above the target after {} sweeps", m_temp_string, relative_error, m_sweeps);
+   }
+
+   magneto::PhysicalProperties finish() {
+      m_algorithm->write_back(m_system.get_lattice_nc());
+      m_visual_output->snapshot(m_system.get_lattice(), true);
+      m_visual_output->end_actions();
+      magneto::get_logger()->info("Finished computations for {}X{} System, T={}", m_job.m_Lx, m_job.m_Ly, m_temp_string);
+      if (m_tau_int == 0.0 && m_autocorrelation_window.size() > 1)
+         set_autocorrelation_time();
+      return { m_statistics, m_measurements, get_t_representation_for_measurements(m_T), m_job.m_Lx, m_job.m_Ly, m_tau_int, m_sweeps };
+   }
+
+   TTemp m_T;
+   const magneto::Job& m_job;
+   magneto::CounterRng m_rng;
+   std::string m_temp_string;
+   std::unique_ptr<magneto::VisualOutput> m_visual_output;
+   std::unique_ptr<magneto::LatticeAlgorithm> m_algorithm;
+   magneto::IsingSystem m_system;
+   magneto::MeasurementStatistics m_statistics;
+   std::vector<magneto::PhysicalMeasurement> m_measurements;
+   std::vector<magneto::PhysicalMeasurement> m_autocorrelation_window;
+   double m_tau_int = 0.0;
+   unsigned int m_measurement_interval = 1;
+   unsigned int m_sweeps_to_measurement = 0;
+   uint64_t m_sweeps = 0;
+};
+
+
 template<class TTemp>
 magneto::PhysicalProperties get_physical_properties(
    const TTemp T, 
-   const magneto::Job& job
+   const magneto::Job& job,
+   const uint32_t temperature_index = 0
 ) {
-   const std::string temp_string = get_temperature_string(T);
-   std::unique_ptr<magneto::VisualOutput> visual_output(get_visual_output(job.m_image_mode.m_mode, job.m_Lx, job.m_Ly, job.m_image_mode, temp_string));
-   std::unique_ptr<magneto::LatticeAlgorithm> algorithm(get_lattice_algorithm(job.m_algorithm, T, job.m_Lx, job.m_Ly, job.m_J));
-
-   magneto::get_logger()->info("Starting computations for {}X{} System, T={}", job.m_Lx, job.m_Ly, temp_string);
-	magneto::IsingSystem system(job.m_J, job.initial_spins);
+   Replica<TTemp> replica(T, job, temperature_index);
+   warmup_system(replica.m_system, T, job, temperature_index, job.m_equilibration);
+   replica.iterate_main();
+   return replica.finish();
+}
 
-   warmup_system(system, T, job.m_start_runs);
 
-   // Main iterations
-   std::vector<magneto::PhysicalMeasurement> measurements;
-	for (unsigned int i = 1; i < job.m_n; ++i) {
-      visual_output->snapshot(system.get_lattice());
-		measurements.emplace_back(get_properties(system));
-      algorithm->run(system.get_lattice_nc());
-	}
-   visual_output->snapshot(system.get_lattice(), true);
-   visual_output->end_actions();
+/// <summary>Runs all temperatures in parallel and exchanges configurations between neighbouring
+/// temperatures every m_exchange_interval sweeps. Every block of sweeps is one parallel region, so
+/// all replicas are synchronized when the swaps are attempted. With a target error, the
+/// temperatures are coupled and stop together once all of them reached it.</summary>
+std::vector<magneto::PhysicalProperties> run_job_replica_exchange(
+   const magneto::Job& job,
+   const std::vector<double>& temps,
+   magneto::TaskScheduler& scheduler
+) {
+   std::vector<std::unique_ptr<Replica<double>>> replicas;
+   for (size_t index = 0; index < temps.size(); ++index)
+      replicas.emplace_back(std::make_unique<Replica<double>>(temps[index], job, static_cast<uint32_t>(index)));
+   std::vector<magneto::SpinLattice*> lattices;
+   for (const auto& replica : replicas)
+      lattices.emplace_back(&replica->m_system.get_lattice_nc());
+
+   const auto get_replica_tasks = [&](const auto& get_work) {
+      std::vector<magneto::Task> tasks;
+      for (size_t index = 0; index < replicas.size(); ++index)
+         tasks.push_back({ get_expected_cost(job, temps[index]), get_work(index) });
+      return tasks;
+   };
+   scheduler.run(get_replica_tasks([&](const size_t index) {
+      return [&, index] {warmup_system(replicas[index]->m_system, temps[index], job, static_cast<uint32_t>(index), job.m_equilibration); };
+   }));
+
+   const bool has_target = job.m_target_rel_error > 0.0;
+   const unsigned int total_sweeps = has_target ? job.m_max_iterations : std::max(job.m_n, 1u) - 1;
+   const auto has_reached_target = [&]() {
+      return std::all_of(std::cbegin(replicas), std::cend(replicas),
+         [](const std::unique_ptr<Replica<double>>& replica) {return replica->has_reached_target_error(); }
+      );
+   };
+   magneto::ReplicaExchange exchange(temps, job.m_J, magneto::CounterRng(job.m_seed, 0, magneto::RngPhase::Exchange));
+   for (unsigned int done = 0; done < total_sweeps && !(has_target && has_reached_target()); ) {
+      const unsigned int sweeps = std::min(job.m_exchange_interval, total_sweeps - done);
+      scheduler.run(get_replica_tasks([&](const size_t index) {
+         return [&, index] {
+            replicas[index]->iterate(sweeps);
+            replicas[index]->m_algorithm->write_back(*lattices[index]);
+         };
+      }));
+      done += sweeps;
+      exchange.attempt_swaps(lattices);
+      for (const auto& replica : replicas)
+         replica->m_algorithm->reset_totals();
+   }
+   exchange.log_acceptance_rates();
+   if (has_target) {
+      for (const auto& replica : replicas)
+         replica->log_iterations();
+   }
 
-   // compute results
-   magneto::get_logger()->info("Finished computations for {}X{} System, T={}", job.m_Lx, job.m_Ly, temp_string);
-   magneto::PhysicalProperties props;
-   props.measurements = measurements;
-   return { measurements, get_t_representation_for_measurements(T), job.m_Lx, job.m_Ly };
+   std::vector<magneto::PhysicalProperties> properties;
+   for (const auto& replica : replicas)
+      properties.emplace_back(replica->finish());
+   return properties;
 }
 
 
@@ -150,6 +475,13 @@ void write_results(const std::vector<magneto::PhysicsResult>& results, const mag
             , fmt::arg("cv", result.cv)
             , fmt::arg("M", result.magnetization)
             , fmt::arg("chi", result.chi)
+            , fmt::arg("binder", result.binder)
+            , fmt::arg("E_err", result.energy_err)
+            , fmt::arg("cv_err", result.cv_err)
+            , fmt::arg("M_err", result.magnetization_err)
+            , fmt::arg("chi_err", result.chi_err)
+            , fmt::arg("n", result.iterations)
+            , fmt::arg("tau", result.tau_int)
          );
       }
       catch (const fmt::format_error& /*e*/) {
@@ -160,36 +492,258 @@ void write_results(const std::vector<magneto::PhysicsResult>& results, const mag
 }
 
 
-std::vector<magneto::PhysicalProperties> run_job_fixed_t(const magneto::Job& job, const std::vector<double>& temps) {
+/// <summary>Runs the temperatures in annealing chains, one per thread
+/// <para>The temperatures are sorted from hot to cold and cut into contiguous chains. The first
+/// temperature of a chain starts from the initial spins, every later one from the final lattice of
+/// its predecessor. Neighbouring equilibrium states are close, so their warmup always uses the
+/// automatic equilibration and usually ends at the first check.</para>
+/// </summary>
+std::vector<magneto::PhysicalProperties> run_job_continuation(
+   const magneto::Job& job,
+   const std::vector<double>& temps,
+   magneto::TaskScheduler& scheduler
+) {
+   std::vector<size_t> order(temps.size());
+   std::iota(std::begin(order), std::end(order), 0);
+   std::stable_sort(std::begin(order), std::end(order), [&](const size_t a, const size_t b) {return temps[a] > temps[b]; });
+   const size_t chain_count = std::min<size_t>(temps.size(), scheduler.get_worker_count());
+   std::vector<std::vector<size_t>> chains(chain_count);
+   for (size_t k = 0; k < order.size(); ++k)
+      chains[k * chain_count / order.size()].emplace_back(order[k]);
+
    std::vector<magneto::PhysicalProperties> properties(temps.size());
-   std::transform(
-      std::execution::par_unseq,
-      std::cbegin(temps),
-      std::cend(temps),
-      std::begin(properties),
-      [&](const double t) {return get_physical_properties(t, job); }
-   );
+   std::vector<magneto::Task> tasks;
+   for (const std::vector<size_t>& chain : chains) {
+      double cost = 0.0;
+      for (const size_t index : chain)
+         cost += get_expected_cost(job, temps[index]);
+      tasks.push_back({ cost, [&] {
+         std::optional<magneto::SpinLattice> previous_lattice;
+         for (const size_t index : chain) {
+            const uint32_t temperature_index = static_cast<uint32_t>(index);
+            Replica<double> replica(temps[index], job, temperature_index);
+            if (previous_lattice.has_value()) {
+               replica.m_system.get_lattice_nc() = previous_lattice.value();
+               warmup_system(replica.m_system, temps[index], job, temperature_index, magneto::Equilibration::Automatic);
+            }
+            else
+               warmup_system(replica.m_system, temps[index], job, temperature_index, job.m_equilibration);
+            replica.iterate_main();
+            properties[index] = replica.finish();
+            previous_lattice = replica.m_system.get_lattice();
+         }
+      } });
+   }
+   scheduler.run(std::move(tasks));
+   return properties;
+}
+
+
+/// <summary>Runs every temperature as one task of the work-stealing scheduler, the ones expected to
+/// take longest first. Exchange and continuation jobs schedule their replicas and chains instead.</summary>
+std::vector<magneto::PhysicalProperties> run_job_fixed_t(
+   const magneto::Job& job,
+   const std::vector<double>& temps,
+   const magneto::ThreadPlan& plan
+) {
+   magneto::TaskScheduler scheduler(plan.m_temperature_threads, [&plan](const unsigned int worker) {magneto::pin_temperature_worker(plan, worker); });
+   if (job.m_exchange_interval > 0 && temps.size() > 1)
+      return run_job_replica_exchange(job, temps, scheduler);
+   if (job.m_continuation && temps.size() > 1)
+      return run_job_continuation(job, temps, scheduler);
+
+   std::vector<magneto::PhysicalProperties> properties(temps.size());
+   std::vector<magneto::Task> tasks;
+   for (size_t index = 0; index < temps.size(); ++index) {
+      tasks.push_back({ get_expected_cost(job, temps[index]), [&, index] {
+         properties[index] = get_physical_properties(temps[index], job, static_cast<uint32_t>(index));
+      } });
+   }
+   scheduler.run(std::move(tasks));
+   if (scheduler.get_steal_count() > 0)
+      magneto::get_logger()->info("Idle workers took over {} temperatures", scheduler.get_steal_count());
    return properties;
 }
 
 
-void run_job(const magneto::Job& job, const std::variant<magneto::LatticeDType, std::vector<double>>& temp_variant) {
+void write_reweighted_results(const std::vector<magneto::PhysicalProperties>& properties, const magneto::Job& job) {
+   const magneto::ReweightConfig& config = job.m_reweight_config;
+   if (config.m_mode == magneto::Reweighting::None)
+      return;
+   const std::vector<magneto::PhysicsResult> results = config.m_mode == magneto::Reweighting::Single
+      ? magneto::get_single_histogram_results(properties, job.m_J, job.m_reweight_temps)
+      : magneto::get_multi_histogram_results(properties, job.m_J, job.m_reweight_temps);
+   write_results(results, { config.m_outputfile, job.m_physics_config.m_format });
+}
+
+
+/// <summary>Derives all temperatures from one density of states estimate. The iterations are
+/// used as production sweeps for the magnetization.</summary>
+std::optional<std::vector<magneto::PhysicsResult>> run_job_wang_landau(
+   const magneto::Job& job,
+   const std::vector<double>& temps,
+   const magneto::ThreadPlan& plan
+) {
+   if (!magneto::is_checkerboard_compatible(job.m_Lx, job.m_Ly)) {
+      magneto::get_logger()->warn("Wang-Landau needs even Lx and Ly, simulating every temperature instead.");
+      return std::nullopt;
+   }
+   magneto::TaskScheduler scheduler(plan.m_temperature_threads, [&plan](const unsigned int worker) {magneto::pin_temperature_worker(plan, worker); });
+   const std::optional<magneto::DensityOfStates> dos = magneto::get_density_of_states(
+      job.m_Lx, job.m_Ly, job.m_wang_landau_windows, job.m_wang_landau_log_f, job.m_n, job.m_seed, scheduler
+   );
+   if (!dos.has_value())
+      return std::nullopt;
+   return magneto::get_physical_results(dos.value(), job.m_J, temps);
+}
+
+
+/// <summary>Step of the schedule an iteration belongs to, the temperature only changes between steps</summary>
+unsigned int get_schedule_step(const magneto::ScheduleConfig& config, const unsigned int iteration, const unsigned int iterations) {
+   if (iterations == 0)
+      return 0;
+   const auto get_share = [&](const size_t steps) {
+      const uint64_t step = static_cast<uint64_t>(iteration) * steps / iterations;
+      return static_cast<unsigned int>(std::min<uint64_t>(step, steps - 1));
+   };
+   if (config.m_mode == magneto::Schedule::Steps)
+      return get_share(std::max(config.m_steps, 1u));
+   else if (config.m_mode == magneto::Schedule::Images)
+      return get_share(config.m_images.size());
+   else
+      return iteration;
+}
+
+
+double get_scheduled_temperature(const magneto::ScheduleConfig& config, const unsigned int step, const unsigned int iterations) {
+   const unsigned int last_step = config.m_mode == magneto::Schedule::Steps ? std::max(config.m_steps, 1u) - 1 : iterations - 1;
+   const double fraction = last_step > 0 ? static_cast<double>(step) / last_step : 0.0;
+   if (config.m_mode == magneto::Schedule::Exponential)
+      return config.m_t_start * pow(config.m_t_end / config.m_t_start, fraction);
+   return config.m_t_start + (config.m_t_end - config.m_t_start) * fraction;
+}
+
+
+bool set_algorithm_temperature(magneto::LatticeAlgorithm& algorithm, const double T) {
+   return algorithm.set_temperature(T);
+}
+
+bool set_algorithm_temperature(magneto::LatticeAlgorithm& algorithm, const magneto::LatticeDType& T) {
+   return algorithm.set_temperature_field(T);
+}
+
+
+/// <summary>Temperature column of the schedule output: the temperature, or the index of the image</summary>
+double get_schedule_value(const double T, const unsigned int /*step*/) {
+   return T;
+}
+
+double get_schedule_value(const magneto::LatticeDType& /*T*/, const unsigned int step) {
+   return step;
+}
+
+
+/// <summary>Runs one system through the temperature schedule of the job and writes iteration,
+/// temperature, E and M after every run
+/// <para>When the temperature changes, the algorithm only rebuilds its lookup tables. The few that
+/// can't are constructed again, on a new random stream so that no randoms are reused.</para>
+/// </summary>
+template<class TTemp, class TTempOfStep>
+void run_job_schedule(const magneto::Job& job, const TTempOfStep& get_temperature) {
+   const magneto::ScheduleConfig& config = job.m_schedule_config;
+   const int site_count = job.m_Lx * job.m_Ly;
+   magneto::IsingSystem system(job.m_J, job.initial_spins);
+   unsigned int step = get_schedule_step(config, 0, job.m_n);
+   TTemp T = get_temperature(step);
+   warmup_system(system, T, job, 0, job.m_equilibration);
+
+   uint32_t stream = 0;
+   const auto get_algorithm = [&](const TTemp& temp) {
+      return get_lattice_algorithm(job.m_algorithm, temp, job.m_Lx, job.m_Ly, job.m_J, magneto::CounterRng(job.m_seed, stream++), job.m_algorithm_threads, job.m_acceptance, job.m_random_mode);
+   };
+   std::unique_ptr<magneto::LatticeAlgorithm> algorithm = get_algorithm(T);
+   std::unique_ptr<magneto::VisualOutput> visual_output = get_visual_output(job.m_image_mode.m_mode, job.m_Lx, job.m_Ly, job.m_image_mode, "schedule");
+   magneto::get_logger()->info("Starting temperature schedule for {}X{} System with {} iterations", job.m_Lx, job.m_Ly, job.m_n);
+
+   std::string file_content;
+   for (unsigned int iteration = 0; iteration < job.m_n; ++iteration) {
+      const unsigned int next_step = get_schedule_step(config, iteration, job.m_n);
+      if (next_step != step) {
+         step = next_step;
+         T = get_temperature(step);
+         if (!set_algorithm_temperature(*algorithm, T))
+            algorithm = get_algorithm(T);
+      }
+      visual_output->snapshot(system.get_lattice());
+      algorithm->run(system.get_lattice_nc());
+      const magneto::PhysicalMeasurement measurement = get_properties(algorithm->get_totals(system.get_lattice_nc()), site_count);
+      file_content += fmt::format("{}, {:.5f}, {:.5f}, {:.5f}\n", iteration, get_schedule_value(T, step), measurement.energy, measurement.magnetization);
+   }
+   visual_output->snapshot(system.get_lattice(), true);
+   visual_output->end_actions();
+   magneto::write_string_to_file(config.m_outputfile, file_content);
+}
+
+
+/// <summary>Independent systems or windows the job can work on at the same time</summary>
+size_t get_parallel_task_count(const magneto::Job& job, const std::variant<magneto::LatticeDType, std::vector<double>>& temp_variant) {
+   if (job.m_schedule_config.m_mode != magneto::Schedule::None || !std::holds_alternative<std::vector<double>>(temp_variant))
+      return 1;
+   if (job.m_wang_landau && magneto::is_checkerboard_compatible(job.m_Lx, job.m_Ly))
+      return job.m_wang_landau_windows;
+   return std::get<std::vector<double>>(temp_variant).size();
+}
+
+
+/// <summary>Plans the threads of the job before anything starts. The RNG pool is configured here,
+/// the lattice threads of the plan replace algorithm_threads for the rest of the job.</summary>
+void run_job(const magneto::Job& unplanned_job, const std::variant<magneto::LatticeDType, std::vector<double>>& temp_variant) {
+   const magneto::ThreadPlan plan = magneto::get_thread_plan(unplanned_job, get_parallel_task_count(unplanned_job, temp_variant));
+   magneto::log_thread_plan(plan);
+   if (plan.m_rng_threads > 0)
+      magneto::RngPool::configure(plan.m_rng_threads, [plan](const unsigned int worker) {magneto::pin_rng_worker(plan, worker); });
+   magneto::Job job = unplanned_job;
+   job.m_algorithm_threads = plan.m_lattice_threads;
+
+   const magneto::ScheduleConfig& schedule = job.m_schedule_config;
+   if (schedule.m_mode == magneto::Schedule::Images) {
+      if (job.m_schedule_temps.empty()) {
+         magneto::get_logger()->error("Schedule mode images needs schedule_images.");
+         return;
+      }
+      run_job_schedule<magneto::LatticeDType>(job, [&](const unsigned int step) {return job.m_schedule_temps[step]; });
+      return;
+   }
+   else if (schedule.m_mode != magneto::Schedule::None) {
+      run_job_schedule<double>(job, [&](const unsigned int step) {return get_scheduled_temperature(schedule, step, job.m_n); });
+      return;
+   }
+
    struct V {
-      V(const magneto::Job& job) : m_job(job) { }
+      V(const magneto::Job& job, const magneto::ThreadPlan& plan) : m_job(job), m_plan(plan) { }
       void operator()(const magneto::LatticeDType& T) {
          [[maybe_unused]] const magneto::PhysicalProperties properties = get_physical_properties(T, m_job);
       }
       void operator()(const std::vector<double>& T) {
-         const std::vector<magneto::PhysicalProperties> properties = run_job_fixed_t(m_job, T);
+         if (m_job.m_wang_landau) {
+            const std::optional<std::vector<magneto::PhysicsResult>> results = run_job_wang_landau(m_job, T, m_plan);
+            if (results.has_value()) {
+               write_results(results.value(), m_job.m_physics_config);
+               return;
+            }
+         }
+         const std::vector<magneto::PhysicalProperties> properties = run_job_fixed_t(m_job, T, m_plan);
          std::vector<magneto::PhysicsResult> results;
          for (const magneto::PhysicalProperties& prop : properties) {
             results.emplace_back(magneto::get_physical_results(prop));
          }
          write_results(results, m_job.m_physics_config);
+         write_reweighted_results(properties, m_job);
       }
       magneto::Job m_job;
+      magneto::ThreadPlan m_plan;
    };
-   std::visit(V(job), temp_variant);
+   std::visit(V(job, plan), temp_variant);
 }
 
 
@@ -204,6 +758,18 @@ void magneto::start() {
       return;
    }
 
-   const auto [job, T] = get_job(parsed_job.value());
+   const auto job_and_temps = get_job(parsed_job.value());
+   if (!job_and_temps.has_value()) {
+      get_logger()->error("Couldn't set up a job from {}", default_config_path.string());
+      return;
+   }
+
+   const auto& [job, T] = job_and_temps.value();
    run_job(job, T);
+
+   if (!RngPool::is_instantiated())
+      return;
+   const RngPool& rng_pool = RngPool::get();
+   if (rng_pool.get_starved_refills() > 0)
+      get_logger()->info("Waited for random buffers {} times, {:.1f} ms in total", rng_pool.get_starved_refills(), rng_pool.get_starved_ns() * 1e-6);
 }
@@ -1,66 +1,19 @@
 #include "physics_tools.h"
-#include <numeric>
-
-namespace {
-   ///<summary>Computes the mean of anything that implements + and / operators</summary>
-   template <class T>
-   T get_mean(const std::vector<T>& values) {
-      const T sum = std::accumulate(values.cbegin(), values.cend(), T());
-      return sum / static_cast<int>(values.size());
-   }
-
-
-   ///<summary>Mean of squared elements</summary>
-   template <class T>
-   T get_squared_mean(const std::vector<T>& values) {
-      const auto& square_op = [](const T init, const T elem) {
-         return init + elem * elem;
-      };
-      const T sum = std::accumulate(values.cbegin(), values.cend(), T(), square_op);
-      return sum / static_cast<int>(values.size());
-   }
-
-
-   ///<summary>Calculates variance with the old trick of Var(x) = |x^2|-|x|^2</summary>
-   double get_variance(const std::vector<double>& values) {
-      const double mean = get_mean(values);
-      return get_squared_mean(values) - mean * mean;
-   }
-
-
-   std::vector<double> get_energies(const std::vector<magneto::PhysicalMeasurement>& properties) {
-      std::vector<double> energies;
-      energies.reserve(properties.size());
-      for (const magneto::PhysicalMeasurement& property : properties)
-         energies.emplace_back(property.energy);
-      return energies;
-   }
-
-
-   std::vector<double> get_mags(const std::vector<magneto::PhysicalMeasurement>& properties) {
-      std::vector<double> energies;
-      energies.reserve(properties.size());
-      for (const magneto::PhysicalMeasurement& property : properties)
-         energies.emplace_back(property.magnetization);
-      return energies;
-   }
-
-
-   double get_energy_variance(const std::vector<magneto::PhysicalMeasurement>& properties) {
-      return get_variance(get_energies(properties));
-   }
-
-   double get_mag_variance(const std::vector<magneto::PhysicalMeasurement>& properties) {
-      return get_variance(get_mags(properties));
-   }
-
-} // namespace {}
 
 
 magneto::PhysicsResult magneto::get_physical_results(const PhysicalProperties& properties){
-   const double mean_energy = get_mean(get_energies(properties.measurements));
-   const double mean_magnetization = get_mean(get_mags(properties.measurements));
-	const double cv = get_energy_variance(properties.measurements) * properties.Lx * properties.Ly / (properties.T * properties.T);
-	const double chi = get_mag_variance(properties.measurements) * properties.Lx * properties.Ly / properties.T;
-	return { properties.T, mean_energy, cv, mean_magnetization, chi };
+   const MeasurementStatistics& statistics = properties.statistics;
+   const double mean_energy = statistics.m_energy.get_mean();
+   const double mean_magnetization = statistics.m_magnetization.get_mean();
+	const double cv = statistics.m_energy.get_variance() * properties.Lx * properties.Ly / (properties.T * properties.T);
+	const double chi = statistics.m_magnetization.get_variance() * properties.Lx * properties.Ly / properties.T;
+   PhysicsResult result{ properties.T, mean_energy, cv, mean_magnetization, chi };
+   result.energy_err = statistics.m_energy_blocking.get_error();
+   result.magnetization_err = statistics.m_magnetization_blocking.get_error();
+   result.cv_err = statistics.m_energy_bins.get_variance_error() * properties.Lx * properties.Ly / (properties.T * properties.T);
+   result.chi_err = statistics.m_magnetization_bins.get_variance_error() * properties.Lx * properties.Ly / properties.T;
+   result.binder = statistics.get_binder_cumulant();
+   result.iterations = properties.sweeps;
+   result.tau_int = properties.tau_int;
+	return result;
 }
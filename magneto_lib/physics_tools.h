@@ -9,6 +9,22 @@ namespace magneto {
       double cv;
       double magnetization;
       double chi;
+
+      /// <summary>Binder cumulant 1 - <m^4>/(3<m^2>^2)</summary>
+      double binder = 0.0;
+
+      /// <summary>Statistical errors: blocking for the means, jackknife for cv and chi. Zero where
+      /// the results don't come from a time series.</summary>
+      double energy_err = 0.0;
+      double cv_err = 0.0;
+      double magnetization_err = 0.0;
+      double chi_err = 0.0;
+
+      /// <summary>Main sweeps behind the results, differs between temperatures with a target error</summary>
+      uint64_t iterations = 0;
+
+      /// <summary>Integrated autocorrelation time in runs of the algorithm</summary>
+      double tau_int = 0.0;
    };
 
 	PhysicsResult get_physical_results(const PhysicalProperties& properties);